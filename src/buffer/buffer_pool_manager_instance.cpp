@@ -12,71 +12,232 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <new>
+#include <utility>
+#include <vector>
+#include <sys/mman.h>
+
+#include "common/exception.h"
+#include "common/logger.h"
 #include "common/macros.h"
+#include "common/util/numa_util.h"
 
 namespace bustub {
 
+/** Size of a huge page on the platforms we run on. */
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/**
+ * Map zeroed, PAGE_SIZE aligned memory for a buffer pool, so that frames can be the source and target of O_DIRECT
+ * I/O. Huge pages are tried first if use_huge_pages is set.
+ * @param[in,out] size number of bytes to map, rounded up to what was actually mapped
+ * @param use_huge_pages true if the memory should be backed by huge pages
+ * @param numa_node the NUMA node to bind the memory to, -1 to leave it to the kernel
+ * @param[out] reserved_huge_pages if not null, set to true if the memory is backed by reserved huge pages
+ * @return the mapped memory
+ */
+static auto MapMemory(size_t *size, bool use_huge_pages, int numa_node, bool *reserved_huge_pages = nullptr)
+    -> void * {
+  void *data = MAP_FAILED;
+  if (use_huge_pages) {
+    size_t huge_size = (*size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    data = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED) {
+      *size = huge_size;
+      if (reserved_huge_pages != nullptr) {
+        *reserved_huge_pages = true;
+      }
+    } else {
+      LOG_WARN("no huge pages reserved, falling back to transparent huge pages");
+    }
+  }
+
+  if (data == MAP_FAILED) {
+    data = mmap(nullptr, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "can't allocate buffer pool memory");
+    }
+    if (use_huge_pages) {
+      madvise(data, *size, MADV_HUGEPAGE);
+    }
+  }
+
+  // Nothing has touched the memory yet, so every page of it will be allocated on the node.
+  if (numa_node >= 0 && !NumaUtil::BindToNode(data, *size, numa_node)) {
+    LOG_WARN("can't bind buffer pool memory to NUMA node %d", numa_node);
+  }
+  return data;
+}
+
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager) {}
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     size_t max_pool_size)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager, replacer_type, max_pool_size) {}
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                                                     DiskManager *disk_manager, LogManager *log_manager)
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerType replacer_type, size_t max_pool_size)
     : pool_size_(pool_size),
+      max_pool_size_(std::max(pool_size, max_pool_size)),
       num_instances_(num_instances),
       instance_index_(instance_index),
       next_page_id_(instance_index),
+      numa_node_(enable_numa_placement
+                     ? NumaUtil::GetOnlineNodes()[instance_index % NumaUtil::GetOnlineNodes().size()]
+                     : -1),
+      pages_size_(max_pool_size_ * sizeof(Page)),
+      frame_data_size_(max_pool_size_ * PAGE_SIZE),
       disk_manager_(disk_manager),
       log_manager_(log_manager) {
   BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
   BUSTUB_ASSERT(
       instance_index < num_instances,
       "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
-  // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  // We allocate a consecutive memory space for the buffer pool, on the NUMA node of the instance if it has one.
+  // Memory is reserved for max_pool_size_ frames, but only the frames that are used are ever touched.
+  pages_ = static_cast<Page *>(MapMemory(&pages_size_, false, numa_node_));
+  frame_data_ = static_cast<char *>(MapMemory(&frame_data_size_, enable_huge_pages, numa_node_, &frame_data_huge_pages_));
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    new (&pages_[i]) Page(frame_data_ + i * PAGE_SIZE);
+  }
+  switch (replacer_type) {
+    case ReplacerType::LRU_K:
+      replacer_ = new LRUKReplacer(max_pool_size_);
+      break;
+    case ReplacerType::TWO_Q:
+      replacer_ = new TwoQReplacer(max_pool_size_);
+      break;
+    case ReplacerType::CLOCK:
+      replacer_ = new ClockReplacer(max_pool_size_);
+      break;
+    case ReplacerType::LRU:
+      replacer_ = new LRUReplacer(max_pool_size_);
+      break;
+  }
+
+  // Pages already in the database file keep their ids; new ids start after the last of them.
+  page_id_t num_pages = disk_manager_->GetNumPages();
+  if (num_pages > next_page_id_) {
+    next_page_id_ += (num_pages - next_page_id_ + num_instances_ - 1) / num_instances_ * num_instances_;
+  }
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
     free_list_.emplace_back(static_cast<int>(i));
   }
+
+  if (enable_page_cleaner) {
+    page_cleaner_thread_ = new std::thread(&BufferPoolManagerInstance::RunPageCleaner, this);
+  }
+  if (enable_buffer_pool_stats_logging) {
+    stats_logger_thread_ = new std::thread(&BufferPoolManagerInstance::RunStatsLogger, this);
+  }
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  if (page_cleaner_thread_ != nullptr) {
+    {
+      std::scoped_lock cleaner_latch(cleaner_latch_);
+      stop_cleaner_ = true;
+    }
+    cleaner_cv_.notify_one();
+    page_cleaner_thread_->join();
+    delete page_cleaner_thread_;
+  }
+  if (stats_logger_thread_ != nullptr) {
+    {
+      std::scoped_lock stats_logger_latch(stats_logger_latch_);
+      stop_stats_logger_ = true;
+    }
+    stats_logger_cv_.notify_one();
+    stats_logger_thread_->join();
+    delete stats_logger_thread_;
+  }
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    pages_[i].~Page();
+  }
+  munmap(pages_, pages_size_);
+  munmap(frame_data_, frame_data_size_);
   delete replacer_;
 }
 
 auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
   // Make sure you call DiskManager::WritePage!
-  latch_.lock();
+  auto &partition = GetPartition(page_id);
+  std::scoped_lock partition_latch(partition.latch_);
 
-  if (page_table_.find(page_id) == page_table_.end()) {
-    latch_.unlock();
+  auto iter = partition.table_.find(page_id);
+  if (iter == partition.table_.end()) {
     return false;
   }
 
-  Page *page = &pages_[page_table_[page_id]];
+  // A page still being read is clean, and writing its frame would overwrite the page with a partial image.
+  Page *page = &pages_[iter->second];
+  if (page->is_loading_) {
+    return true;
+  }
   disk_manager_->WritePage(page_id, page->data_);
   page->is_dirty_ = false;
 
-  latch_.unlock();
   return true;
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  // You can do it!
-  latch_.lock();
+  WriteBackDirtyPages();
+  disk_manager_->Sync();
+}
 
-  for (auto &&[page_id, frame_id] : page_table_) {
-    Page *page = &pages_[frame_id];
-    if (page->is_dirty_) {
-      disk_manager_->WritePage(page_id, page->data_);
-      page->is_dirty_ = false;
+void BufferPoolManagerInstance::WriteBackDirtyPages() {
+  // Pin the dirty pages so that they can't be evicted while they are written. The replacer is left alone: a pinned
+  // victim is skipped by GetFreeFrame and handed back to the replacer when it is unpinned.
+  std::vector<std::pair<page_id_t, frame_id_t>> dirty_pages;
+  for (auto &partition : page_table_) {
+    std::scoped_lock partition_latch(partition.latch_);
+    for (auto &&[page_id, frame_id] : partition.table_) {
+      Page *page = &pages_[frame_id];
+      if (page->is_dirty_) {
+        if (page->pin_count_++ == 0) {
+          partition.pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+        }
+        // cleared before the write, so that changes made during the write mark the page dirty again; set again if
+        // the write fails
+        page->is_dirty_ = false;
+        dirty_pages.emplace_back(page_id, frame_id);
+      }
     }
   }
+  WriteBackPinnedPages(&dirty_pages);
+}
 
-  latch_.unlock();
+void BufferPoolManagerInstance::WriteBackPinnedPages(std::vector<std::pair<page_id_t, frame_id_t>> *pages) {
+  if (pages->empty()) {
+    return;
+  }
+  std::sort(pages->begin(), pages->end());
+
+  std::vector<page_id_t> page_ids;
+  std::vector<const char *> page_data;
+  page_ids.reserve(pages->size());
+  page_data.reserve(pages->size());
+  for (auto &&[page_id, frame_id] : *pages) {
+    page_ids.push_back(page_id);
+    page_data.push_back(pages_[frame_id].data_);
+  }
+  bool written = disk_manager_->WritePages(page_ids, page_data);
+
+  for (auto &&[page_id, frame_id] : *pages) {
+    auto &partition = GetPartition(page_id);
+    std::scoped_lock partition_latch(partition.latch_);
+    // which pages made it is unknown, and writing a page twice does no harm
+    if (!written) {
+      pages_[frame_id].is_dirty_ = true;
+    }
+    if (--pages_[frame_id].pin_count_ == 0) {
+      partition.pinned_frames_.fetch_sub(1, std::memory_order_relaxed);
+      UnpinReplacer(frame_id);
+    }
+  }
 }
 
 auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
@@ -85,35 +246,31 @@ auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
-  latch_.lock();
+  auto latch = LockLatch();
 
   frame_id_t frame_id;
-  Page *page;
-
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-    page = &pages_[frame_id];
-  } else if (replacer_->Victim(&frame_id)) {
-    page = &pages_[frame_id];
-    if (page->is_dirty_) {
-      disk_manager_->WritePage(page->page_id_, page->data_);
-    }
-    page_table_.erase(page->page_id_);
-    page->ResetMemory();
-  } else {
-    latch_.unlock();
+  if (!GetFreeFrame(&frame_id)) {
     return nullptr;
   }
 
-  *page_id = AllocatePage();
-  page_table_[*page_id] = frame_id;
+  Page *page = &pages_[frame_id];
+  page->ResetMemory();
 
+  page_id_t fresh_page_id = next_page_id_;
+  *page_id = AllocatePage();
   page->page_id_ = *page_id;
   page->pin_count_ = 1;
-  page->is_dirty_ = false;
+  // A recycled id still has the deleted page on disk, which must not come back if the new page is evicted clean.
+  page->is_dirty_ = *page_id != fresh_page_id;
+  page->is_cold_ = false;
+  replacer_->RecordAccess(frame_id);
+
+  auto &partition = GetPartition(*page_id);
+  std::scoped_lock partition_latch(partition.latch_);
+  partition.table_[*page_id] = frame_id;
+  partition.pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+  UpdatePinnedFramesHighWater();
 
-  latch_.unlock();
   return page;
 }
 
@@ -125,51 +282,165 @@ auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
+  return FetchPgWithStrategyImp(page_id, nullptr);
+}
+
+auto BufferPoolManagerInstance::FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
   if (page_id == INVALID_PAGE_ID) {
     return nullptr;
   }
 
-  latch_.lock();
+  while (true) {
+    Page *page = PinResidentPage(page_id, strategy == nullptr);
+    if (page != nullptr) {
+      return page;
+    }
+
+    auto latch = LockLatch();
 
-  if (page_table_.find(page_id) != page_table_.end()) {
-    frame_id_t frame_id = page_table_[page_id];
-    Page *page = &pages_[frame_id];
-    if (page->pin_count_ == 0) {
-      replacer_->Pin(frame_id);
+    // Another thread may have brought the page in, or started reading it, while we were waiting for the latch.
+    if (IsResident(page_id)) {
+      continue;
     }
-    ++page->pin_count_;
 
-    latch_.unlock();
+    frame_id_t frame_id;
+    if (!GetFrame(page_id, strategy, &frame_id)) {
+      return nullptr;
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    page = &pages_[frame_id];
+    page->page_id_ = page_id;
+    page->pin_count_ = 1;
+    page->is_dirty_ = false;
+    page->is_cold_ = strategy != nullptr;
+    GetPartition(page_id).pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+    UpdatePinnedFramesHighWater();
+    if (strategy == nullptr) {
+      replacer_->RecordAccess(frame_id);
+    }
+    StartLoading(page_id, frame_id);
+    latch.unlock();
+
+    try {
+      disk_manager_->ReadPage(page_id, page->data_);
+    } catch (const Exception &) {
+      // The page is corrupted. Give the frame back, so that the failed fetch costs nothing but the exception.
+      FinishLoading(page_id, frame_id, false);
+      throw;
+    }
+    FinishLoading(page_id, frame_id, true);
+
     return page;
   }
+}
+
+auto BufferPoolManagerInstance::FetchPgsImp(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy)
+    -> std::vector<Page *> {
+  std::vector<Page *> pages;
+  PendingFetch fetch = BeginFetchPages(page_ids, strategy, &pages);
+  try {
+    disk_manager_->ReadPages(fetch.read_ids_, fetch.read_buffers_);
+  } catch (const Exception &) {
+    EndFetchPages(page_ids, strategy, &fetch, false, &pages);
+    throw;
+  }
 
-  frame_id_t frame_id;
-  Page *page;
+  try {
+    EndFetchPages(page_ids, strategy, &fetch, true, &pages);
+  } catch (const Exception &) {
+    for (size_t i = 0; i < pages.size(); ++i) {
+      if (pages[i] != nullptr) {
+        UnpinPgImp(page_ids[i], false);
+      }
+    }
+    throw;
+  }
 
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-    page = &pages_[frame_id];
-  } else if (replacer_->Victim(&frame_id)) {
-    page = &pages_[frame_id];
-    if (page->is_dirty_) {
-      disk_manager_->WritePage(page->page_id_, page->data_);
+  return pages;
+}
+
+auto BufferPoolManagerInstance::BeginFetchPages(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy,
+                                                std::vector<Page *> *pages) -> PendingFetch {
+  PendingFetch fetch;
+  pages->assign(page_ids.size(), nullptr);
+  std::vector<size_t> misses;
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    if (page_ids[i] == INVALID_PAGE_ID) {
+      continue;
     }
-    page_table_.erase(page->page_id_);
-  } else {
-    latch_.unlock();
-    return nullptr;
+    (*pages)[i] = PinResidentPage(page_ids[i], strategy == nullptr);
+    if ((*pages)[i] == nullptr) {
+      misses.push_back(i);
+    }
+  }
+  if (misses.empty()) {
+    return fetch;
   }
 
-  page_table_[page_id] = frame_id;
+  auto latch = LockLatch();
 
-  disk_manager_->ReadPage(page_id, page->data_);
-  page->page_id_ = page_id;
-  page->pin_count_ = 1;
-  page->is_dirty_ = false;
+  // Assign a frame to every miss and publish it as loading, so that the reads can be done without latch_.
+  for (size_t i : misses) {
+    page_id_t page_id = page_ids[i];
+    if (auto iter = fetch.loading_.find(page_id); iter != fetch.loading_.end()) {
+      (*pages)[i] = &pages_[iter->second];
+      ++(*pages)[i]->pin_count_;
+      continue;
+    }
+    if (IsResident(page_id)) {
+      fetch.deferred_.push_back(i);
+      continue;
+    }
 
-  latch_.unlock();
-  return page;
+    frame_id_t frame_id;
+    if (!GetFrame(page_id, strategy, &frame_id)) {
+      break;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    Page *page = &pages_[frame_id];
+    page->page_id_ = page_id;
+    page->pin_count_ = 1;
+    page->is_dirty_ = false;
+    page->is_cold_ = strategy != nullptr;
+    GetPartition(page_id).pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+    UpdatePinnedFramesHighWater();
+    if (strategy == nullptr) {
+      replacer_->RecordAccess(frame_id);
+    }
+    StartLoading(page_id, frame_id);
+    (*pages)[i] = page;
+
+    fetch.loading_[page_id] = frame_id;
+    fetch.read_ids_.push_back(page_id);
+    fetch.read_buffers_.push_back(page->data_);
+  }
+
+  return fetch;
+}
+
+void BufferPoolManagerInstance::EndFetchPages(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy,
+                                              PendingFetch *fetch, bool loaded, std::vector<Page *> *pages) {
+  if (!loaded) {
+    // A page is corrupted. Give back every frame assigned to the batch and release the pins on the resident pages.
+    for (size_t i = 0; i < pages->size(); ++i) {
+      if ((*pages)[i] != nullptr && fetch->loading_.count(page_ids[i]) == 0) {
+        UnpinPgImp(page_ids[i], false);
+      }
+      (*pages)[i] = nullptr;
+    }
+    for (auto &&[page_id, frame_id] : fetch->loading_) {
+      FinishLoading(page_id, frame_id, false);
+    }
+    return;
+  }
+
+  for (auto &&[page_id, frame_id] : fetch->loading_) {
+    FinishLoading(page_id, frame_id, true);
+  }
+  for (size_t i : fetch->deferred_) {
+    (*pages)[i] = FetchPgWithStrategyImp(page_ids[i], strategy);
+  }
 }
 
 auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
@@ -178,66 +449,486 @@ auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
   // 1.   If P does not exist, return true.
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  latch_.lock();
+  auto latch = LockLatch();
 
-  if (page_table_.find(page_id) == page_table_.end()) {
-    latch_.unlock();
+  auto &partition = GetPartition(page_id);
+  std::scoped_lock partition_latch(partition.latch_);
+
+  auto iter = partition.table_.find(page_id);
+  if (iter == partition.table_.end()) {
+    DeallocatePage(page_id);
     return true;
   }
 
-  frame_id_t frame_id = page_table_[page_id];
+  frame_id_t frame_id = iter->second;
   Page *page = &pages_[frame_id];
 
   if (page->pin_count_ > 0) {
-    latch_.unlock();
     return false;
   }
 
   DeallocatePage(page_id);
   page->ResetMemory();
+  page->page_id_ = INVALID_PAGE_ID;
+  page->is_dirty_ = false;
 
-  replacer_->Pin(frame_id);
-  page_table_.erase(page_id);
+  replacer_->Remove(frame_id);
+  partition.table_.erase(iter);
   free_list_.emplace_back(frame_id);
 
-  latch_.unlock();
   return true;
 }
 
 auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
-  latch_.lock();
+  auto &partition = GetPartition(page_id);
+  std::scoped_lock partition_latch(partition.latch_);
 
-  if (page_table_.find(page_id) == page_table_.end()) {
-    latch_.unlock();
+  auto iter = partition.table_.find(page_id);
+  if (iter == partition.table_.end()) {
     return false;
   }
 
-  frame_id_t frame_id = page_table_[page_id];
+  return UnpinFrame(iter->second, is_dirty);
+}
+
+void BufferPoolManagerInstance::UnpinGuardedPgImp(Page *page, bool is_dirty) {
+  // The guard holds a pin, so the page can't have left its frame and no page table lookup is needed.
+  auto &partition = GetPartition(page->GetPageId());
+  std::scoped_lock partition_latch(partition.latch_);
+  UnpinFrame(static_cast<frame_id_t>(page - pages_), is_dirty);
+}
+
+auto BufferPoolManagerInstance::UnpinFrame(frame_id_t frame_id, bool is_dirty) -> bool {
   Page *page = &pages_[frame_id];
 
   if (page->pin_count_ == 0) {
-    latch_.unlock();
     return false;
   }
 
-  --page->pin_count_;
-  if (page->pin_count_ == 0) {
+  // Mark dirty before the frame can become a victim.
+  if (is_dirty) {
+    page->is_dirty_ = true;
+  }
+
+  if (--page->pin_count_ == 0) {
+    GetPartition(page->page_id_).pinned_frames_.fetch_sub(1, std::memory_order_relaxed);
+    UnpinReplacer(frame_id);
+  }
+
+  return true;
+}
+
+auto BufferPoolManagerInstance::PinResidentPage(page_id_t page_id, bool record_access) -> Page * {
+  auto &partition = GetPartition(page_id);
+  std::unique_lock partition_latch(partition.latch_);
+
+  auto iter = partition.table_.find(page_id);
+  while (iter != partition.table_.end() && pages_[iter->second].is_loading_) {
+    // The page is being read without latch_. Its frame may be given back if the read fails, so look it up again.
+    partition.loaded_cv_.wait(partition_latch);
+    iter = partition.table_.find(page_id);
+  }
+  if (iter == partition.table_.end()) {
+    return nullptr;
+  }
+
+  partition.hits_.fetch_add(1, std::memory_order_relaxed);
+  Page *page = &pages_[iter->second];
+  // Only a bulk scan's own misses are cold. A scan touching a resident page must not send it to the eviction end,
+  // while a regular access warms up a page a scan brought in.
+  if (record_access) {
+    page->is_cold_ = false;
+  }
+  if (page->pin_count_++ == 0) {
+    partition.pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+    replacer_->Pin(iter->second);
+  }
+  if (record_access) {
+    replacer_->RecordAccess(iter->second);
+  }
+
+  return page;
+}
+
+void BufferPoolManagerInstance::UnpinReplacer(frame_id_t frame_id) {
+  // Pages of a bulk scan go to the eviction end, so that they don't push out the pages a plain LRU keeps.
+  if (pages_[frame_id].is_cold_) {
+    replacer_->UnpinCold(frame_id);
+  } else {
     replacer_->Unpin(frame_id);
   }
+}
 
-  if (is_dirty) {
-    page->is_dirty_ = true;
+auto BufferPoolManagerInstance::IsResident(page_id_t page_id) -> bool {
+  auto &partition = GetPartition(page_id);
+  std::scoped_lock partition_latch(partition.latch_);
+  return partition.table_.count(page_id) > 0;
+}
+
+void BufferPoolManagerInstance::StartLoading(page_id_t page_id, frame_id_t frame_id) {
+  auto &partition = GetPartition(page_id);
+  std::scoped_lock partition_latch(partition.latch_);
+  pages_[frame_id].is_loading_ = true;
+  partition.table_[page_id] = frame_id;
+}
+
+void BufferPoolManagerInstance::FinishLoading(page_id_t page_id, frame_id_t frame_id, bool loaded) {
+  Page *page = &pages_[frame_id];
+  auto &partition = GetPartition(page_id);
+  {
+    std::scoped_lock partition_latch(partition.latch_);
+    page->is_loading_ = false;
+    if (!loaded) {
+      partition.table_.erase(page_id);
+      page->page_id_ = INVALID_PAGE_ID;
+      page->pin_count_ = 0;
+    }
+  }
+  partition.loaded_cv_.notify_all();
+  if (loaded) {
+    return;
+  }
+
+  // The frame is no longer reachable through the page table, so only this thread knows it.
+  auto latch = LockLatch();
+  partition.pinned_frames_.fetch_sub(1, std::memory_order_relaxed);
+  replacer_->Remove(frame_id);
+  free_list_.emplace_back(frame_id);
+}
+
+auto BufferPoolManagerInstance::GetFreeFrame(frame_id_t *frame_id) -> bool {
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    return true;
+  }
+
+  // While the page cleaner runs, dirty victims get a second chance until every candidate has been looked at once.
+  size_t second_chances = page_cleaner_thread_ != nullptr ? replacer_->Size() : 0;
+  bool waited_for_cleaner = false;
+  while (true) {
+    if (!replacer_->Victim(frame_id)) {
+      // Victims the page cleaner is writing are pinned by it, so wait for its pass and look again, without second
+      // chances this time.
+      if (waited_for_cleaner || !WaitForPageCleaner()) {
+        return false;
+      }
+      waited_for_cleaner = true;
+      second_chances = 0;
+      continue;
+    }
+    Page *page = &pages_[*frame_id];
+    {
+      auto &partition = GetPartition(page->page_id_);
+      std::scoped_lock partition_latch(partition.latch_);
+      // A resident-page hit may have pinned the victim after the replacer handed it out. It goes back to the
+      // replacer once it is unpinned again.
+      if (page->pin_count_ > 0) {
+        continue;
+      }
+      if (page->is_dirty_ && second_chances > 0) {
+        --second_chances;
+        UnpinReplacer(*frame_id);
+        WakePageCleaner();
+        continue;
+      }
+      partition.table_.erase(page->page_id_);
+    }
+    // The frame is about to hold another page, whose history starts over.
+    replacer_->Remove(*frame_id);
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+
+    // The page is no longer reachable through the page table, and any fetch of it waits on latch_ until the
+    // write-back below is done.
+    if (page->is_dirty_) {
+      disk_manager_->WritePage(page->page_id_, page->data_);
+      page->is_dirty_ = false;
+      dirty_writebacks_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+}
+
+auto BufferPoolManagerInstance::GetFrame(page_id_t page_id, BufferAccessStrategy *strategy, frame_id_t *frame_id)
+    -> bool {
+  if (strategy == nullptr) {
+    return GetFreeFrame(frame_id);
   }
 
-  latch_.unlock();
+  // A ring larger than an eighth of the pool would defeat its purpose.
+  auto ring_size = std::max<size_t>(1, std::min(strategy->GetRingSize(), pool_size_ / 8));
+  auto &ring = strategy->GetRing(instance_index_, ring_size);
+  page_id_t &slot = ring.page_ids_[ring.next_];
+  if (!ReclaimFrame(slot, frame_id) && !GetFreeFrame(frame_id)) {
+    return false;
+  }
+  slot = page_id;
+  ring.next_ = (ring.next_ + 1) % ring.page_ids_.size();
   return true;
 }
 
+auto BufferPoolManagerInstance::ReclaimFrame(page_id_t page_id, frame_id_t *frame_id) -> bool {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+
+  Page *page;
+  {
+    auto &partition = GetPartition(page_id);
+    std::scoped_lock partition_latch(partition.latch_);
+    auto iter = partition.table_.find(page_id);
+    if (iter == partition.table_.end() || pages_[iter->second].pin_count_ > 0) {
+      return false;
+    }
+    *frame_id = iter->second;
+    page = &pages_[*frame_id];
+    replacer_->Remove(*frame_id);
+    partition.table_.erase(iter);
+  }
+  evictions_.fetch_add(1, std::memory_order_relaxed);
+
+  // As in GetFreeFrame, any fetch of the page waits on latch_ until the write-back is done.
+  if (page->is_dirty_) {
+    disk_manager_->WritePage(page->page_id_, page->data_);
+    page->is_dirty_ = false;
+    dirty_writebacks_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+void BufferPoolManagerInstance::RunPageCleaner() {
+  std::unique_lock cleaner_latch(cleaner_latch_);
+  while (!stop_cleaner_) {
+    cleaner_cv_.wait(cleaner_latch, [this] { return stop_cleaner_ || clean_requested_; });
+    if (stop_cleaner_) {
+      break;
+    }
+    clean_requested_ = false;
+    ++cleaner_passes_started_;
+    cleaner_latch.unlock();
+    CleanFrames();
+    cleaner_latch.lock();
+    ++cleaner_passes_done_;
+    cleaner_done_cv_.notify_all();
+  }
+}
+
+void BufferPoolManagerInstance::WakePageCleaner() {
+  {
+    std::scoped_lock cleaner_latch(cleaner_latch_);
+    clean_requested_ = true;
+  }
+  cleaner_cv_.notify_one();
+}
+
+auto BufferPoolManagerInstance::WaitForPageCleaner() -> bool {
+  if (page_cleaner_thread_ == nullptr) {
+    return false;
+  }
+  std::unique_lock cleaner_latch(cleaner_latch_);
+  if (!clean_requested_ && cleaner_passes_done_ == cleaner_passes_started_) {
+    return false;
+  }
+  uint64_t pass = cleaner_passes_started_ + (clean_requested_ ? 1 : 0);
+  cleaner_done_cv_.wait(cleaner_latch, [this, pass] { return stop_cleaner_ || cleaner_passes_done_ >= pass; });
+  return true;
+}
+
+void BufferPoolManagerInstance::CleanNow() {
+  if (page_cleaner_thread_ == nullptr) {
+    CleanFrames();
+    return;
+  }
+  std::unique_lock cleaner_latch(cleaner_latch_);
+  uint64_t pass = cleaner_passes_started_ + 1;
+  clean_requested_ = true;
+  cleaner_cv_.notify_one();
+  cleaner_done_cv_.wait(cleaner_latch, [this, pass] { return cleaner_passes_done_ >= pass; });
+}
+
+void BufferPoolManagerInstance::CleanFrames() {
+  if (disk_manager_->IsShutDown()) {
+    return;
+  }
+  const size_t cleaner_target = pool_size_ / 4 + 1;
+  size_t num_clean = 0;
+  for (size_t i = 0; i < pool_size_; ++i) {
+    if (pages_[i].pin_count_ == 0 && !pages_[i].is_dirty_) {
+      ++num_clean;
+    }
+  }
+
+  // Pin the frames to clean, as WriteBackDirtyPages does, and only write them once every latch is released.
+  std::vector<std::pair<page_id_t, frame_id_t>> dirty_pages;
+  for (auto &partition : page_table_) {
+    if (num_clean >= cleaner_target) {
+      break;
+    }
+    std::scoped_lock partition_latch(partition.latch_);
+    for (auto &&[page_id, frame_id] : partition.table_) {
+      Page *page = &pages_[frame_id];
+      if (page->pin_count_ == 0 && page->is_dirty_) {
+        page->pin_count_ = 1;
+        partition.pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+        cleaner_pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+        page->is_dirty_ = false;
+        dirty_pages.emplace_back(page_id, frame_id);
+        if (++num_clean >= cleaner_target) {
+          break;
+        }
+      }
+    }
+  }
+  WriteBackPinnedPages(&dirty_pages);
+  cleaner_pinned_frames_.fetch_sub(dirty_pages.size(), std::memory_order_relaxed);
+  dirty_writebacks_.fetch_add(dirty_pages.size(), std::memory_order_relaxed);
+}
+
+auto BufferPoolManagerInstance::Resize(size_t pool_size) -> bool {
+  BUSTUB_ASSERT(pool_size > 0 && pool_size <= max_pool_size_, "pool size must be between 1 and the maximum size");
+  auto latch = LockLatch();
+
+  if (pool_size >= pool_size_) {
+    for (size_t i = pool_size_; i < pool_size; ++i) {
+      free_list_.emplace_back(static_cast<frame_id_t>(i));
+    }
+    pool_size_ = pool_size;
+    return true;
+  }
+
+  // Check every frame to retire before evicting any of them, so that a pinned page leaves the pool as it was. The
+  // latches of all partitions are held until the pages are out of the page table, so nobody can pin them meanwhile.
+  std::vector<std::unique_lock<std::mutex>> partition_latches;
+  partition_latches.reserve(PAGE_TABLE_PARTITIONS);
+  for (auto &partition : page_table_) {
+    partition_latches.emplace_back(partition.latch_);
+  }
+  for (size_t i = pool_size; i < pool_size_; ++i) {
+    if (pages_[i].page_id_ != INVALID_PAGE_ID && pages_[i].pin_count_ > 0) {
+      return false;
+    }
+  }
+  std::vector<frame_id_t> evicted;
+  for (size_t i = pool_size; i < pool_size_; ++i) {
+    Page *page = &pages_[i];
+    if (page->page_id_ != INVALID_PAGE_ID) {
+      replacer_->Remove(static_cast<frame_id_t>(i));
+      GetPartition(page->page_id_).table_.erase(page->page_id_);
+      evicted.push_back(static_cast<frame_id_t>(i));
+    }
+  }
+  partition_latches.clear();
+
+  // Once a page is out of the page table, nobody can pin it any more.
+  for (frame_id_t frame_id : evicted) {
+    Page *page = &pages_[frame_id];
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+    if (page->is_dirty_) {
+      disk_manager_->WritePage(page->page_id_, page->data_);
+      page->is_dirty_ = false;
+      dirty_writebacks_.fetch_add(1, std::memory_order_relaxed);
+    }
+    page->page_id_ = INVALID_PAGE_ID;
+  }
+
+  // Every frame to retire is free now.
+  free_list_.remove_if([pool_size](frame_id_t frame_id) { return static_cast<size_t>(frame_id) >= pool_size; });
+  size_t release_begin = pool_size * PAGE_SIZE;
+  size_t release_end = pool_size_ * PAGE_SIZE;
+  if (frame_data_huge_pages_) {
+    // Reserved huge pages can only be released whole. The frames after pool_size_ are unused, so the huge page the
+    // old end falls into can go too.
+    release_begin = (release_begin + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    release_end = (release_end + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  }
+  if (release_begin < release_end &&
+      madvise(frame_data_ + release_begin, release_end - release_begin, MADV_DONTNEED) != 0) {
+    LOG_WARN("can't return the memory of retired frames to the operating system");
+  }
+  pool_size_ = pool_size;
+  return true;
+}
+
+void BufferPoolManagerInstance::RunStatsLogger() {
+  std::unique_lock stats_logger_latch(stats_logger_latch_);
+  while (!stop_stats_logger_) {
+    stats_logger_cv_.wait_for(stats_logger_latch, buffer_pool_stats_interval);
+    if (stop_stats_logger_) {
+      break;
+    }
+    LOG_INFO("buffer pool instance %u: %s", instance_index_, GetStats().ToString().c_str());
+  }
+}
+
+auto BufferPoolManagerInstance::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  for (auto &partition : page_table_) {
+    stats.hits_ += partition.hits_.load(std::memory_order_relaxed);
+  }
+  stats.misses_ = misses_.load(std::memory_order_relaxed);
+  stats.evictions_ = evictions_.load(std::memory_order_relaxed);
+  stats.dirty_writebacks_ = dirty_writebacks_.load(std::memory_order_relaxed);
+  stats.latch_wait_time_ = std::chrono::nanoseconds(latch_wait_ns_.load(std::memory_order_relaxed));
+  stats.pinned_frames_high_water_ = pinned_frames_high_water_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+auto BufferPoolManagerInstance::LockLatch() -> std::unique_lock<std::mutex> {
+  std::unique_lock latch(latch_, std::try_to_lock);
+  if (!latch.owns_lock()) {
+    auto start = std::chrono::steady_clock::now();
+    latch.lock();
+    auto wait = std::chrono::steady_clock::now() - start;
+    latch_wait_ns_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count(),
+                             std::memory_order_relaxed);
+  }
+  return latch;
+}
+
+auto BufferPoolManagerInstance::GetUnpinnedFrameCount() const -> size_t {
+  size_t pool_size = pool_size_;
+  size_t pinned = GetPinnedFrameCount();
+  size_t cleaning = cleaner_pinned_frames_.load(std::memory_order_relaxed);
+  pinned = pinned > cleaning ? pinned - cleaning : 0;
+  return pinned < pool_size ? pool_size - pinned : 0;
+}
+
+auto BufferPoolManagerInstance::GetPinnedFrameCount() const -> size_t {
+  size_t pinned = 0;
+  for (const auto &partition : page_table_) {
+    pinned += partition.pinned_frames_.load(std::memory_order_relaxed);
+  }
+  return pinned;
+}
+
+void BufferPoolManagerInstance::UpdatePinnedFramesHighWater() {
+  size_t pinned = GetPinnedFrameCount();
+  size_t high_water = pinned_frames_high_water_.load(std::memory_order_relaxed);
+  while (pinned > high_water && !pinned_frames_high_water_.compare_exchange_weak(high_water, pinned)) {
+  }
+}
+
 auto BufferPoolManagerInstance::AllocatePage() -> page_id_t {
-  const page_id_t next_page_id = next_page_id_;
-  next_page_id_ += num_instances_;
-  ValidatePageId(next_page_id);
-  return next_page_id;
+  page_id_t page_id = disk_manager_->ReuseFreePage(num_instances_, instance_index_);
+  if (page_id != INVALID_PAGE_ID && IsResident(page_id)) {
+    // A fetch of the deleted page, e.g. through a stale pointer, still holds a copy of it. The page table can't map
+    // the id to both pages, so the id waits until the copy is evicted.
+    disk_manager_->DeallocatePage(page_id);
+    page_id = INVALID_PAGE_ID;
+  }
+  if (page_id == INVALID_PAGE_ID) {
+    page_id = next_page_id_;
+    next_page_id_ += num_instances_;
+  }
+  ValidatePageId(page_id);
+  return page_id;
+}
+
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) {
+  // Ids that were never handed out must not be, or AllocatePage would hand them out twice.
+  if (page_id < next_page_id_) {
+    disk_manager_->DeallocatePage(page_id);
+  }
 }
 
 void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
@@ -14,16 +14,67 @@
 
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages)
+    : num_frames_(num_pages), frames_((num_pages + FRAMES_PER_WORD - 1) / FRAMES_PER_WORD) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
-auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool { return false; }
+auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool {
+  if (Size() == 0) {
+    return false;
+  }
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+  // The first sweep clears every reference bit, so the second one finds a victim unless the remaining frames are
+  // pinned in the meantime.
+  for (size_t step = 0; step < 2 * num_frames_; ++step) {
+    auto candidate = static_cast<frame_id_t>(hand_.fetch_add(1) % num_frames_);
+    auto &word = FrameWord(candidate);
+    const uint64_t evictable = FrameBits(candidate, EVICTABLE_BIT);
+    const uint64_t referenced = FrameBits(candidate, REFERENCE_BIT);
+    uint64_t bits = word.load();
+    while ((bits & evictable) != 0) {
+      if ((bits & referenced) != 0) {
+        word.fetch_and(~referenced);
+        break;
+      }
+      // Claim the frame unless another thread pinned, unpinned or claimed it since the load.
+      if (word.compare_exchange_weak(bits, bits & ~evictable)) {
+        *frame_id = candidate;
+        return true;
+      }
+    }
+  }
+  return false;
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= num_frames_) {
+    return;
+  }
+  FrameWord(frame_id).fetch_and(~FrameBits(frame_id, EVICTABLE_BIT));
+}
 
-auto ClockReplacer::Size() -> size_t { return 0; }
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= num_frames_) {
+    return;
+  }
+  FrameWord(frame_id).fetch_or(FrameBits(frame_id, EVICTABLE_BIT | REFERENCE_BIT));
+}
+
+void ClockReplacer::UnpinCold(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= num_frames_) {
+    return;
+  }
+  FrameWord(frame_id).fetch_and(~FrameBits(frame_id, REFERENCE_BIT));
+  FrameWord(frame_id).fetch_or(FrameBits(frame_id, EVICTABLE_BIT));
+}
+
+auto ClockReplacer::Size() -> size_t {
+  size_t size = 0;
+  for (auto &word : frames_) {
+    size += __builtin_popcountll(word.load() & 0x5555555555555555ULL);
+  }
+  return size;
+}
 
 }  // namespace bustub
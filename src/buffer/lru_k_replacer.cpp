@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k)
+    : capacity_(num_pages), k_(k), frames_(num_pages), access_times_(num_pages * k) {}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+auto LRUKReplacer::Victim(frame_id_t *frame_id) -> bool {
+  size_t window = std::min(VICTIM_WINDOW, capacity_);
+  size_t start = hand_.fetch_add(window);
+  for (size_t scanned = 0; scanned < capacity_; scanned += window) {
+    // Frames with fewer than k accesses come first, then the frame whose k-th most recent access is the oldest.
+    size_t victim = capacity_;
+    bool victim_has_k = false;
+    uint64_t victim_time = 0;
+    for (size_t j = 0; j < window; ++j) {
+      size_t i = (start + scanned + j) % capacity_;
+      if (!frames_[i].evictable_.load()) {
+        continue;
+      }
+      auto frame = static_cast<frame_id_t>(i);
+      uint64_t num_accesses = frames_[i].num_accesses_.load();
+      bool has_k = num_accesses >= k_;
+      // With k or more accesses, the oldest slot of the ring holds the k-th most recent access.
+      uint64_t time = num_accesses == 0 ? 0 : AccessTime(frame, has_k ? num_accesses : 0).load();
+      if (victim == capacity_ || has_k < victim_has_k || (has_k == victim_has_k && time < victim_time)) {
+        victim = i;
+        victim_has_k = has_k;
+        victim_time = time;
+      }
+    }
+    // Claim the frame unless another thread pinned or claimed it since it was looked at.
+    bool evictable = true;
+    if (victim != capacity_ && frames_[victim].evictable_.compare_exchange_strong(evictable, false)) {
+      *frame_id = static_cast<frame_id_t>(victim);
+      return true;
+    }
+  }
+  return false;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  if (!IsValid(frame_id)) {
+    return;
+  }
+  frames_[frame_id].evictable_.store(false);
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  if (!IsValid(frame_id)) {
+    return;
+  }
+  frames_[frame_id].evictable_.store(true);
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  if (!IsValid(frame_id) || IsCorrelatedAccess(&frames_[frame_id].last_reference_)) {
+    return;
+  }
+  uint64_t i = frames_[frame_id].num_accesses_.fetch_add(1);
+  AccessTime(frame_id, i).store(Now());
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  if (!IsValid(frame_id)) {
+    return;
+  }
+  frames_[frame_id].evictable_.store(false);
+  frames_[frame_id].num_accesses_.store(0);
+  frames_[frame_id].last_reference_.store(0);
+}
+
+auto LRUKReplacer::Size() -> size_t {
+  size_t size = 0;
+  for (auto &frame : frames_) {
+    size += frame.evictable_.load() ? 1 : 0;
+  }
+  return size;
+}
+
+}  // namespace bustub
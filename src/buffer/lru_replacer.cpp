@@ -14,48 +14,62 @@
 
 namespace bustub {
 
-LRUReplacer::LRUReplacer(size_t num_pages) : capacity_(num_pages) {}
+LRUReplacer::LRUReplacer(size_t num_pages) : capacity_(num_pages), frames_(num_pages) {}
 
 LRUReplacer::~LRUReplacer() = default;
 
 auto LRUReplacer::Victim(frame_id_t *frame_id) -> bool {
-  latch_.lock();
-
-  if (mp_.empty()) {
-    latch_.unlock();
-    return false;
+  // Every pass of the hand takes a chance from each evictable frame, so a victim turns up within CHANCES + 1 passes
+  // unless the remaining frames are pinned in the meantime.
+  for (size_t step = 0; step < (CHANCES + 1) * capacity_; ++step) {
+    size_t candidate = hand_.fetch_add(1) % capacity_;
+    auto &frame = frames_[candidate];
+    uint8_t chances = frame.load();
+    while (chances != 0) {
+      // Take a chance, or claim the frame without one, unless another thread pinned or unpinned it since the load.
+      uint8_t next = chances == LAST_CHANCE ? 0 : chances - 1;
+      if (frame.compare_exchange_weak(chances, next)) {
+        if (next == 0) {
+          *frame_id = static_cast<frame_id_t>(candidate);
+          return true;
+        }
+        break;
+      }
+    }
   }
-
-  *frame_id = lst_.back();
-  mp_.erase(lst_.back());
-  lst_.pop_back();
-
-  latch_.unlock();
-  return true;
+  return false;
 }
 
 void LRUReplacer::Pin(frame_id_t frame_id) {
-  latch_.lock();
-
-  if (mp_.find(frame_id) != mp_.end()) {
-    lst_.erase(mp_[frame_id]);
-    mp_.erase(frame_id);
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= capacity_) {
+    return;
   }
-
-  latch_.unlock();
+  frames_[frame_id].store(0);
 }
 
 void LRUReplacer::Unpin(frame_id_t frame_id) {
-  latch_.lock();
-
-  if (mp_.find(frame_id) == mp_.end() && mp_.size() != capacity_) {
-    lst_.push_front(frame_id);
-    mp_[frame_id] = lst_.begin();
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= capacity_) {
+    return;
   }
+  // A frame that is already evictable keeps its place.
+  uint8_t not_evictable = 0;
+  frames_[frame_id].compare_exchange_strong(not_evictable, LAST_CHANCE + CHANCES);
+}
 
-  latch_.unlock();
+void LRUReplacer::UnpinCold(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= capacity_) {
+    return;
+  }
+  uint8_t not_evictable = 0;
+  frames_[frame_id].compare_exchange_strong(not_evictable, LAST_CHANCE);
 }
 
-auto LRUReplacer::Size() -> size_t { return mp_.size(); }
+auto LRUReplacer::Size() -> size_t {
+  size_t size = 0;
+  for (auto &frame : frames_) {
+    size += frame.load() != 0 ? 1 : 0;
+  }
+  return size;
+}
 
 }  // namespace bustub
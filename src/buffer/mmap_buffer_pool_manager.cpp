@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/mmap_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/mmap_buffer_pool_manager.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <new>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+MmapBufferPoolManager::MmapBufferPoolManager(const std::string &db_file) {
+  if (enable_page_compression) {
+    throw Exception(ExceptionType::INCOMPATIBLE_FILE, "compressed database files can't be mapped");
+  }
+  fd_ = open(db_file.c_str(), O_RDONLY);
+  struct stat stat_buf;
+  if (fd_ < 0 || fstat(fd_, &stat_buf) != 0) {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+    throw Exception("can't open db file");
+  }
+  num_pages_ = stat_buf.st_size / PAGE_SIZE;
+
+  if (num_pages_ > 0) {
+    void *data = mmap(nullptr, num_pages_ * PAGE_SIZE, PROT_READ, MAP_SHARED, fd_, 0);
+    if (data == MAP_FAILED) {
+      close(fd_);
+      throw Exception("can't map db file");
+    }
+    data_ = static_cast<char *>(data);
+  }
+
+  chunks_ = std::make_unique<std::atomic<Page *>[]>((num_pages_ + PAGES_PER_CHUNK - 1) / PAGES_PER_CHUNK);
+}
+
+MmapBufferPoolManager::~MmapBufferPoolManager() {
+  for (size_t chunk = 0; chunk * PAGES_PER_CHUNK < num_pages_; ++chunk) {
+    Page *pages = chunks_[chunk].load();
+    if (pages != nullptr) {
+      DestroyChunk(pages, GetChunkSize(chunk));
+    }
+  }
+  if (data_ != nullptr) {
+    munmap(data_, num_pages_ * PAGE_SIZE);
+  }
+  close(fd_);
+}
+
+auto MmapBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= num_pages_) {
+    return nullptr;
+  }
+  return &GetChunk(page_id / PAGES_PER_CHUNK)[page_id % PAGES_PER_CHUNK];
+}
+
+auto MmapBufferPoolManager::GetChunk(size_t chunk) -> Page * {
+  Page *pages = chunks_[chunk].load(std::memory_order_acquire);
+  if (pages != nullptr) {
+    return pages;
+  }
+
+  // Every page counts as pinned for as long as the buffer pool exists, since none is ever evicted.
+  size_t first = chunk * PAGES_PER_CHUNK;
+  size_t count = GetChunkSize(chunk);
+  pages = static_cast<Page *>(::operator new[](count * sizeof(Page), std::align_val_t(alignof(Page))));
+  for (size_t i = 0; i < count; ++i) {
+    new (&pages[i]) Page(data_ + (first + i) * PAGE_SIZE);
+    pages[i].page_id_ = static_cast<page_id_t>(first + i);
+    pages[i].pin_count_ = 1;
+  }
+
+  // Threads fetching pages of the same chunk may race to create it; the first one wins.
+  Page *created = nullptr;
+  if (!chunks_[chunk].compare_exchange_strong(created, pages, std::memory_order_acq_rel)) {
+    DestroyChunk(pages, count);
+    return created;
+  }
+  return pages;
+}
+
+void MmapBufferPoolManager::DestroyChunk(Page *pages, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    pages[i].~Page();
+  }
+  ::operator delete[](pages, std::align_val_t(alignof(Page)));
+}
+
+auto MmapBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  return !is_dirty && page_id >= 0 && static_cast<size_t>(page_id) < num_pages_;
+}
+
+auto MmapBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
+  return page_id >= 0 && static_cast<size_t>(page_id) < num_pages_;
+}
+
+auto MmapBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
+  *page_id = INVALID_PAGE_ID;
+  return nullptr;
+}
+
+auto MmapBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
+  return page_id < 0 || static_cast<size_t>(page_id) >= num_pages_;
+}
+
+}  // namespace bustub
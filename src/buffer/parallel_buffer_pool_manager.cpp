@@ -12,16 +12,24 @@
 
 #include "buffer/parallel_buffer_pool_manager.h"
 
+#include <exception>
+#include <future>  // NOLINT
+#include <vector>
+
+#include "common/util/numa_util.h"
+
 namespace bustub {
 
 ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : num_instances_(num_instances), pool_size_(pool_size), start_index_(0) {
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     size_t max_pool_size)
+    : num_instances_(num_instances), disk_manager_(disk_manager) {
   // Allocate and create individual BufferPoolManagerInstances
   buffer_pool_manager_instance_ = new BufferPoolManagerInstance *[num_instances_];
   for (size_t i = 0; i < num_instances_; ++i) {
     buffer_pool_manager_instance_[i] =
-        new BufferPoolManagerInstance(pool_size, num_instances_, i, disk_manager, log_manager);
+        new BufferPoolManagerInstance(pool_size, num_instances_, i, disk_manager, log_manager, replacer_type,
+                                      max_pool_size);
   }
 }
 
@@ -35,27 +43,140 @@ ParallelBufferPoolManager::~ParallelBufferPoolManager() {
 
 auto ParallelBufferPoolManager::GetPoolSize() -> size_t {
   // Get size of all BufferPoolManagerInstances
-  return num_instances_ * pool_size_;
+  size_t pool_size = 0;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    pool_size += buffer_pool_manager_instance_[i]->GetPoolSize();
+  }
+  return pool_size;
 }
 
-auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManager * {
+auto ParallelBufferPoolManager::Resize(size_t pool_size) -> bool {
+  // Growing can't fail, so the instances that shrink go first. If one of them can't, the ones before it grow back,
+  // and no instance is left with a different size than the others.
+  std::vector<size_t> old_sizes(num_instances_);
+  for (size_t i = 0; i < num_instances_; ++i) {
+    old_sizes[i] = buffer_pool_manager_instance_[i]->GetPoolSize();
+  }
+  for (size_t i = 0; i < num_instances_; ++i) {
+    if (pool_size < old_sizes[i] && !buffer_pool_manager_instance_[i]->Resize(pool_size)) {
+      for (size_t j = 0; j < i; ++j) {
+        if (pool_size < old_sizes[j]) {
+          buffer_pool_manager_instance_[j]->Resize(old_sizes[j]);
+        }
+      }
+      return false;
+    }
+  }
+  for (size_t i = 0; i < num_instances_; ++i) {
+    if (pool_size >= old_sizes[i]) {
+      buffer_pool_manager_instance_[i]->Resize(pool_size);
+    }
+  }
+  return true;
+}
+
+auto ParallelBufferPoolManager::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    stats += buffer_pool_manager_instance_[i]->GetStats();
+  }
+  return stats;
+}
+
+auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance * {
   // Get BufferPoolManager responsible for handling given page id. You can use this method in your other methods.
   return buffer_pool_manager_instance_[page_id % num_instances_];
 }
 
 auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
   // Fetch page for page_id from responsible BufferPoolManagerInstance
-  return dynamic_cast<BufferPoolManagerInstance *>(GetBufferPoolManager(page_id))->FetchPgImp(page_id);
+  return GetBufferPoolManager(page_id)->FetchPgImp(page_id);
+}
+
+auto ParallelBufferPoolManager::FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPgWithStrategyImp(page_id, strategy);
+}
+
+auto ParallelBufferPoolManager::FetchPgsImp(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy)
+    -> std::vector<Page *> {
+  // Group the requests by responsible BufferPoolManagerInstance, remembering where each result goes
+  std::vector<std::vector<page_id_t>> instance_page_ids(num_instances_);
+  std::vector<std::vector<size_t>> instance_positions(num_instances_);
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    if (page_ids[i] == INVALID_PAGE_ID) {
+      continue;
+    }
+    instance_page_ids[page_ids[i] % num_instances_].push_back(page_ids[i]);
+    instance_positions[page_ids[i] % num_instances_].push_back(i);
+  }
+
+  // Assign frames to the misses of every instance, and read them all with one DiskManager::ReadPages call. Page ids
+  // are striped across the instances, so consecutive misses of different instances still coalesce into one read.
+  std::vector<std::vector<Page *>> instance_pages(num_instances_);
+  std::vector<BufferPoolManagerInstance::PendingFetch> fetches(num_instances_);
+  std::vector<page_id_t> read_ids;
+  std::vector<char *> read_buffers;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    if (instance_page_ids[i].empty()) {
+      continue;
+    }
+    fetches[i] = buffer_pool_manager_instance_[i]->BeginFetchPages(instance_page_ids[i], strategy, &instance_pages[i]);
+    read_ids.insert(read_ids.end(), fetches[i].read_ids_.begin(), fetches[i].read_ids_.end());
+    read_buffers.insert(read_buffers.end(), fetches[i].read_buffers_.begin(), fetches[i].read_buffers_.end());
+  }
+
+  std::exception_ptr error;
+  try {
+    disk_manager_->ReadPages(read_ids, read_buffers);
+  } catch (const Exception &) {
+    error = std::current_exception();
+  }
+
+  // Every instance publishes or gives back its frames before the exception propagates, so no frame stays loading.
+  bool loaded = error == nullptr;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    if (instance_page_ids[i].empty()) {
+      continue;
+    }
+    try {
+      buffer_pool_manager_instance_[i]->EndFetchPages(instance_page_ids[i], strategy, &fetches[i], loaded,
+                                                      &instance_pages[i]);
+    } catch (const Exception &) {
+      error = std::current_exception();
+    }
+  }
+  if (error != nullptr) {
+    for (size_t i = 0; i < num_instances_; ++i) {
+      for (size_t j = 0; j < instance_pages[i].size(); ++j) {
+        if (instance_pages[i][j] != nullptr) {
+          buffer_pool_manager_instance_[i]->UnpinPgImp(instance_page_ids[i][j], false);
+        }
+      }
+    }
+    std::rethrow_exception(error);
+  }
+
+  std::vector<Page *> pages(page_ids.size(), nullptr);
+  for (size_t i = 0; i < num_instances_; ++i) {
+    for (size_t j = 0; j < instance_pages[i].size(); ++j) {
+      pages[instance_positions[i][j]] = instance_pages[i][j];
+    }
+  }
+  return pages;
 }
 
 auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
   // Unpin page_id from responsible BufferPoolManagerInstance
-  return dynamic_cast<BufferPoolManagerInstance *>(GetBufferPoolManager(page_id))->UnpinPgImp(page_id, is_dirty);
+  return GetBufferPoolManager(page_id)->UnpinPgImp(page_id, is_dirty);
+}
+
+void ParallelBufferPoolManager::UnpinGuardedPgImp(Page *page, bool is_dirty) {
+  GetBufferPoolManager(page->GetPageId())->UnpinGuardedPgImp(page, is_dirty);
 }
 
 auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
   // Flush page_id from responsible BufferPoolManagerInstance
-  return dynamic_cast<BufferPoolManagerInstance *>(GetBufferPoolManager(page_id))->FlushPgImp(page_id);
+  return GetBufferPoolManager(page_id)->FlushPgImp(page_id);
 }
 
 auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
@@ -65,36 +186,45 @@ auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
   // starting index and return nullptr
   // 2.   Bump the starting index (mod number of instances) to start search at a different BPMI each time this function
   // is called
-  latch_.lock();
-
-  size_t curr_index = start_index_;
-  start_index_ = (start_index_ + 1) % num_instances_;
-
-  latch_.unlock();
-
-  Page *page = nullptr;
-
-  for (int i = 0; i < static_cast<int>(num_instances_); ++i) {
-    page = dynamic_cast<BufferPoolManagerInstance *>(buffer_pool_manager_instance_[(curr_index + i) % num_instances_])
-               ->NewPgImp(page_id);
-    if (page != nullptr) {
-      break;
+  uint32_t start_index = next_instance_.fetch_add(1) % num_instances_;
+  // With NUMA placement, the instances on the node of the calling thread are tried first, so that the page it is
+  // about to fill lives in local memory. Otherwise every instance has node -1 and the first pass covers them all.
+  int local_node = buffer_pool_manager_instance_[0]->GetNumaNode() < 0 ? -1 : NumaUtil::GetCurrentNode();
+
+  for (bool local_pass : {true, false}) {
+    for (uint32_t i = 0; i < num_instances_; ++i) {
+      BufferPoolManagerInstance *instance = buffer_pool_manager_instance_[(start_index + i) % num_instances_];
+      // Instances with every frame pinned cannot create a page, so don't wait for their latch.
+      if ((instance->GetNumaNode() == local_node) != local_pass || instance->GetUnpinnedFrameCount() == 0) {
+        continue;
+      }
+      Page *page = instance->NewPgImp(page_id);
+      if (page != nullptr) {
+        return page;
+      }
     }
   }
 
-  return page;
+  return nullptr;
 }
 
 auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
   // Delete page_id from responsible BufferPoolManagerInstance
-  return dynamic_cast<BufferPoolManagerInstance *>(GetBufferPoolManager(page_id))->DeletePgImp(page_id);
+  return GetBufferPoolManager(page_id)->DeletePgImp(page_id);
 }
 
 void ParallelBufferPoolManager::FlushAllPgsImp() {
   // flush all pages from all BufferPoolManagerInstances
-  for (size_t i = 0; i < num_instances_; ++i) {
-    dynamic_cast<BufferPoolManagerInstance *>(buffer_pool_manager_instance_[i])->FlushAllPgsImp();
+  std::vector<std::future<void>> pending;
+  for (size_t i = 1; i < num_instances_; ++i) {
+    pending.push_back(std::async(std::launch::async, &BufferPoolManagerInstance::WriteBackDirtyPages,
+                                 buffer_pool_manager_instance_[i]));
+  }
+  buffer_pool_manager_instance_[0]->WriteBackDirtyPages();
+  for (auto &future : pending) {
+    future.get();
   }
+  disk_manager_->Sync();
 }
 
 }  // namespace bustub
@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer.cpp
+//
+// Identification: src/buffer/two_q_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_q_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+TwoQReplacer::TwoQReplacer(size_t num_pages)
+    : capacity_(num_pages), a1_threshold_(num_pages / 4), frames_(num_pages) {}
+
+TwoQReplacer::~TwoQReplacer() = default;
+
+auto TwoQReplacer::Victim(frame_id_t *frame_id) -> bool {
+  bool from_a1 = a1_size_.load() > static_cast<int64_t>(a1_threshold_);
+  size_t window = std::min(VICTIM_WINDOW, capacity_);
+  size_t start = hand_.fetch_add(window);
+  for (size_t scanned = 0; scanned < capacity_; scanned += window) {
+    // Find the head of both queues in the window: the oldest first access in A1, and the oldest last access in Am.
+    // Frames unpinned without ever being accessed count as A1 frames that were accessed at time 0.
+    size_t a1_victim = capacity_;
+    size_t am_victim = capacity_;
+    uint64_t a1_time = 0;
+    uint64_t am_time = 0;
+    for (size_t j = 0; j < window; ++j) {
+      size_t i = (start + scanned + j) % capacity_;
+      auto &frame = frames_[i];
+      if (!frame.evictable_.load()) {
+        continue;
+      }
+      uint64_t num_accesses = frame.num_accesses_.load();
+      if (num_accesses <= 1) {
+        uint64_t time = num_accesses == 0 ? 0 : frame.first_access_.load();
+        if (a1_victim == capacity_ || time < a1_time) {
+          a1_victim = i;
+          a1_time = time;
+        }
+      } else {
+        uint64_t time = frame.last_access_.load();
+        if (am_victim == capacity_ || time < am_time) {
+          am_victim = i;
+          am_time = time;
+        }
+      }
+    }
+
+    size_t victim = (from_a1 && a1_victim != capacity_) || am_victim == capacity_ ? a1_victim : am_victim;
+    // Claim the frame unless another thread pinned or claimed it since it was looked at.
+    bool evictable = true;
+    if (victim != capacity_ && frames_[victim].evictable_.compare_exchange_strong(evictable, false)) {
+      LeaveA1(&frames_[victim]);
+      *frame_id = static_cast<frame_id_t>(victim);
+      return true;
+    }
+  }
+  return false;
+}
+
+void TwoQReplacer::Pin(frame_id_t frame_id) {
+  if (!IsValid(frame_id)) {
+    return;
+  }
+  frames_[frame_id].evictable_.store(false);
+}
+
+void TwoQReplacer::Unpin(frame_id_t frame_id) {
+  if (!IsValid(frame_id)) {
+    return;
+  }
+  auto &frame = frames_[frame_id];
+  // A victim that is handed back, or a frame unpinned before its first access, is in A1 again.
+  if (frame.num_accesses_.load() <= 1) {
+    EnterA1(&frame);
+  }
+  frame.evictable_.store(true);
+}
+
+void TwoQReplacer::RecordAccess(frame_id_t frame_id) {
+  if (!IsValid(frame_id)) {
+    return;
+  }
+  auto &frame = frames_[frame_id];
+  if (IsCorrelatedAccess(&frame.last_reference_)) {
+    return;
+  }
+  uint64_t now = Now();
+  uint64_t num_accesses = frame.num_accesses_.fetch_add(1);
+  if (num_accesses == 0) {
+    frame.first_access_.store(now);
+    EnterA1(&frame);
+  } else if (num_accesses == 1) {
+    LeaveA1(&frame);
+  }
+  frame.last_access_.store(now);
+}
+
+void TwoQReplacer::Remove(frame_id_t frame_id) {
+  if (!IsValid(frame_id)) {
+    return;
+  }
+  auto &frame = frames_[frame_id];
+  frame.evictable_.store(false);
+  LeaveA1(&frame);
+  frame.num_accesses_.store(0);
+  frame.last_reference_.store(0);
+}
+
+auto TwoQReplacer::Size() -> size_t {
+  size_t size = 0;
+  for (auto &frame : frames_) {
+    size += frame.evictable_.load() ? 1 : 0;
+  }
+  return size;
+}
+
+}  // namespace bustub
@@ -18,6 +18,26 @@ std::atomic<bool> enable_logging(false);
 
 std::chrono::duration<int64_t> log_timeout = std::chrono::seconds(1);
 
+std::atomic<bool> enable_page_cleaner(true);
+
+std::atomic<bool> enable_huge_pages(false);
+
+std::atomic<bool> enable_readahead(true);
+
+std::atomic<bool> enable_numa_placement(false);
+
+std::atomic<bool> enable_page_checksums(true);
+
+std::atomic<bool> enable_page_compression(false);
+
+std::atomic<bool> enable_optimistic_lock_coupling(false);
+
+std::atomic<bool> enable_normalized_keys(false);
+
+std::atomic<bool> enable_buffer_pool_stats_logging(false);
+
+std::chrono::milliseconds buffer_pool_stats_interval = std::chrono::seconds(10);
+
 std::chrono::milliseconds cycle_detection_interval = std::chrono::milliseconds(50);
 
 }  // namespace bustub
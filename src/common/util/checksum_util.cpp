@@ -0,0 +1,132 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// checksum_util.cpp
+//
+// Identification: src/common/util/checksum_util.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/checksum_util.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace bustub {
+
+/** The CRC32C polynomial, bit reversed. */
+static constexpr uint32_t CRC32C_POLYNOMIAL = 0x82F63B78;
+
+/** @return the table of the CRC32C remainders of every byte value */
+static auto MakeCrc32cTable() -> std::array<uint32_t, 256> {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc & 1) != 0 ? (crc >> 1) ^ CRC32C_POLYNOMIAL : crc >> 1;
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+static auto Crc32cSoftware(const char *data, size_t length) -> uint32_t {
+  static const std::array<uint32_t, 256> table = MakeCrc32cTable();
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < length; ++i) {
+    crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+#if defined(__x86_64__)
+/**
+ * The crc32 instruction has a latency of three cycles but a throughput of one per cycle, so a page is processed as
+ * three interleaved streams of STREAM_LENGTH bytes, whose CRCs are then combined.
+ */
+static constexpr size_t STREAM_LENGTH = 1360;
+
+/** @return the CRC register after feeding STREAM_LENGTH zero bytes into a register holding crc */
+__attribute__((target("sse4.2"))) static auto ShiftByStream(uint32_t crc) -> uint32_t {
+  uint64_t state = crc;
+  for (size_t i = 0; i < STREAM_LENGTH; i += sizeof(uint64_t)) {
+    state = _mm_crc32_u64(state, 0);
+  }
+  return static_cast<uint32_t>(state);
+}
+
+/** Shifting the CRC register is linear, so it is tabulated per byte of the register. */
+static auto MakeShiftTable() -> std::array<std::array<uint32_t, 256>, 4> {
+  std::array<std::array<uint32_t, 256>, 4> table{};
+  for (size_t byte = 0; byte < 4; ++byte) {
+    for (uint32_t value = 0; value < 256; ++value) {
+      table[byte][value] = ShiftByStream(value << (8 * byte));
+    }
+  }
+  return table;
+}
+
+static auto ShiftCombine(uint32_t crc, uint32_t next) -> uint32_t {
+  static const std::array<std::array<uint32_t, 256>, 4> table = MakeShiftTable();
+  return table[0][crc & 0xFF] ^ table[1][(crc >> 8) & 0xFF] ^ table[2][(crc >> 16) & 0xFF] ^ table[3][crc >> 24] ^
+         next;
+}
+
+__attribute__((target("sse4.2"))) static auto Crc32cHardware(const char *data, size_t length) -> uint32_t {
+  uint64_t crc = 0xFFFFFFFF;
+  for (; length >= 3 * STREAM_LENGTH; data += 3 * STREAM_LENGTH, length -= 3 * STREAM_LENGTH) {
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    for (size_t i = 0; i < STREAM_LENGTH; i += sizeof(uint64_t)) {
+      uint64_t word0;
+      uint64_t word1;
+      uint64_t word2;
+      std::memcpy(&word0, data + i, sizeof(uint64_t));
+      std::memcpy(&word1, data + STREAM_LENGTH + i, sizeof(uint64_t));
+      std::memcpy(&word2, data + 2 * STREAM_LENGTH + i, sizeof(uint64_t));
+      crc = _mm_crc32_u64(crc, word0);
+      crc1 = _mm_crc32_u64(crc1, word1);
+      crc2 = _mm_crc32_u64(crc2, word2);
+    }
+    crc = ShiftCombine(ShiftCombine(static_cast<uint32_t>(crc), static_cast<uint32_t>(crc1)),
+                       static_cast<uint32_t>(crc2));
+  }
+  for (; length >= sizeof(uint64_t); data += sizeof(uint64_t), length -= sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    crc = _mm_crc32_u64(crc, word);
+  }
+  auto crc32 = static_cast<uint32_t>(crc);
+  for (; length > 0; ++data, --length) {
+    crc32 = _mm_crc32_u8(crc32, static_cast<uint8_t>(*data));
+  }
+  return ~crc32;
+}
+#endif
+
+auto ChecksumUtil::HasHardwareCrc32c() -> bool {
+#if defined(__x86_64__)
+  static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+  return has_sse42;
+#else
+  return false;
+#endif
+}
+
+auto ChecksumUtil::Crc32c(const char *data, size_t length) -> uint32_t {
+#if defined(__x86_64__)
+  if (HasHardwareCrc32c()) {
+    return Crc32cHardware(data, length);
+  }
+#endif
+  return Crc32cSoftware(data, length);
+}
+
+}  // namespace bustub
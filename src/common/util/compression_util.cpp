@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compression_util.cpp
+//
+// Identification: src/common/util/compression_util.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/compression_util.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace bustub {
+
+/** Zero runs shorter than this cost more to encode as a token than to keep as literal bytes. */
+static constexpr size_t MIN_ZERO_RUN = 8;
+/** The longest run a token can describe. */
+static constexpr size_t MAX_RUN = UINT16_MAX;
+
+/** @return the length of the run of zero bytes at the start of src, at most max_length */
+static auto ZeroRunLength(const char *src, size_t max_length) -> size_t {
+  size_t run = 0;
+  while (run < max_length && src[run] == 0) {
+    ++run;
+  }
+  return run;
+}
+
+auto CompressionUtil::CompressZeroRuns(const char *src, size_t length, char *dst, size_t capacity) -> size_t {
+  size_t in = 0;
+  size_t out = 0;
+  while (in < length) {
+    // The literal ends where a zero run long enough to be worth a token starts.
+    size_t literal = 0;
+    while (in + literal < length && literal < MAX_RUN &&
+           ZeroRunLength(src + in + literal, std::min(MIN_ZERO_RUN, length - in - literal)) < MIN_ZERO_RUN) {
+      ++literal;
+    }
+    size_t zeros = ZeroRunLength(src + in + literal, std::min(MAX_RUN, length - in - literal));
+    if (out + 2 * sizeof(uint16_t) + literal > capacity) {
+      return 0;
+    }
+
+    auto literal16 = static_cast<uint16_t>(literal);
+    auto zeros16 = static_cast<uint16_t>(zeros);
+    std::memcpy(dst + out, &literal16, sizeof(uint16_t));
+    std::memcpy(dst + out + sizeof(uint16_t), src + in, literal);
+    std::memcpy(dst + out + sizeof(uint16_t) + literal, &zeros16, sizeof(uint16_t));
+    out += 2 * sizeof(uint16_t) + literal;
+    in += literal + zeros;
+  }
+  return out;
+}
+
+auto CompressionUtil::DecompressZeroRuns(const char *src, size_t src_length, char *dst, size_t length) -> bool {
+  size_t in = 0;
+  size_t out = 0;
+  while (in < src_length) {
+    uint16_t literal;
+    uint16_t zeros;
+    if (in + 2 * sizeof(uint16_t) > src_length) {
+      return false;
+    }
+    std::memcpy(&literal, src + in, sizeof(uint16_t));
+    if (in + 2 * sizeof(uint16_t) + literal > src_length || out + literal > length) {
+      return false;
+    }
+    std::memcpy(dst + out, src + in + sizeof(uint16_t), literal);
+    std::memcpy(&zeros, src + in + sizeof(uint16_t) + literal, sizeof(uint16_t));
+    if (out + literal + zeros > length) {
+      return false;
+    }
+    std::memset(dst + out + literal, 0, zeros);
+    in += 2 * sizeof(uint16_t) + literal;
+    out += literal + zeros;
+  }
+  return out == length;
+}
+
+}  // namespace bustub
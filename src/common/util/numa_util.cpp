@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// numa_util.cpp
+//
+// Identification: src/common/util/numa_util.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/numa_util.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bustub {
+
+auto NumaUtil::GetOnlineNodes() -> const std::vector<int> & {
+  // The online node list is a comma separated list of ids and ranges like "0-3" or "0,2"; ids can have gaps.
+  static const std::vector<int> online_nodes = [] {
+    std::vector<int> nodes;
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string range;
+    while (std::getline(online, range, ',')) {
+      size_t dash = range.find('-');
+      int first = std::stoi(range.substr(0, dash));
+      int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (int node = first; node <= last; ++node) {
+        nodes.push_back(node);
+      }
+    }
+    if (nodes.empty()) {
+      nodes.push_back(0);
+    }
+    return nodes;
+  }();
+  return online_nodes;
+}
+
+auto NumaUtil::GetCurrentNode() -> int {
+#ifdef __linux__
+  unsigned cpu;
+  unsigned node;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+    return static_cast<int>(node);
+  }
+#endif
+  return 0;
+}
+
+auto NumaUtil::BindToNode(void *addr, size_t len, int node) -> bool {
+#ifdef __linux__
+  constexpr size_t bits_per_word = sizeof(unsigned long) * 8;  // NOLINT
+  std::vector<unsigned long> node_mask(node / bits_per_word + 1, 0);  // NOLINT
+  node_mask[node / bits_per_word] |= 1UL << (node % bits_per_word);
+  // The kernel ignores the last bit of maxnode, hence the + 1.
+  return syscall(SYS_mbind, addr, len, MPOL_BIND, node_mask.data(), node_mask.size() * bits_per_word + 1, 0) == 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace bustub
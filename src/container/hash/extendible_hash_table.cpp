@@ -27,17 +27,14 @@ HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager
                                      const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
     : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
   //  implement me!
-  Page *page = buffer_pool_manager_->NewPage(&directory_page_id_);
-  auto dir_page = reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+  BasicPageGuard dir_guard = buffer_pool_manager_->NewPageGuarded(&directory_page_id_);
+  auto dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
 
   page_id_t bucket_page_id;
-  buffer_pool_manager_->NewPage(&bucket_page_id);
+  buffer_pool_manager_->NewPageGuarded(&bucket_page_id);
 
   dir_page->SetPageId(directory_page_id_);
   dir_page->SetBucketPageId(0, bucket_page_id);
-
-  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
-  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
 }
 
 /*****************************************************************************
@@ -68,15 +65,15 @@ inline auto HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *di
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::FetchDirectoryPage() -> HashTableDirectoryPage * {
-  Page *page = buffer_pool_manager_->FetchPage(directory_page_id_);
-  return reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+auto HASH_TABLE_TYPE::FetchDirectoryPage(BasicPageGuard *guard) -> HashTableDirectoryPage * {
+  *guard = buffer_pool_manager_->FetchPageBasic(directory_page_id_);
+  return reinterpret_cast<HashTableDirectoryPage *>(guard->GetPage()->GetData());
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE * {
-  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
-  return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id, BasicPageGuard *guard) -> HASH_TABLE_BUCKET_TYPE * {
+  *guard = buffer_pool_manager_->FetchPageBasic(bucket_page_id);
+  return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(guard->GetPage()->GetData());
 }
 
 /*****************************************************************************
@@ -86,22 +83,15 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
   table_latch_.RLock();
 
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  uint32_t index = Hash(key) & dir_page->GetGlobalDepthMask();
-  page_id_t bucket_page_id = dir_page->GetBucketPageId(index);
-  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
-  page->RLatch();
+  BasicPageGuard dir_guard;
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage(&dir_guard);
+  ReadPageGuard bucket_guard = buffer_pool_manager_->FetchPageRead(KeyToPageId(key, dir_page));
 
-  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  dir_guard.Drop();
   table_latch_.RUnlock();
 
-  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
-  bool is_find = bucket_page->MyGetValue(key, comparator_, result);
-
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
-
-  return is_find;
+  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket_guard.GetPage()->GetData());
+  return bucket_page->MyGetValue(key, comparator_, result);
 }
 
 /*****************************************************************************
@@ -111,54 +101,48 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
   table_latch_.RLock();
 
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  uint32_t index = Hash(key) & dir_page->GetGlobalDepthMask();
-  page_id_t bucket_page_id = dir_page->GetBucketPageId(index);
-  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
-  page->WLatch();
+  BasicPageGuard dir_guard;
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage(&dir_guard);
+  WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(KeyToPageId(key, dir_page));
 
-  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  dir_guard.Drop();
   table_latch_.RUnlock();
 
-  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
-  bool is_insert = false;
-
-  if (!bucket_page->IsExist(key, value, comparator_)) {
-    is_insert = bucket_page->MyInsert(key, value, comparator_);
-
-    if (!is_insert) {
-      page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
-      return SplitInsert(transaction, key, value);
-    }
+  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket_guard.GetPage()->GetData());
+  if (bucket_page->IsExist(key, value, comparator_)) {
+    return false;
   }
 
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(bucket_page_id, is_insert);
+  if (!bucket_page->MyInsert(key, value, comparator_)) {
+    bucket_guard.Drop();
+    return SplitInsert(transaction, key, value);
+  }
 
-  return is_insert;
+  bucket_guard.SetDirty();
+  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
   table_latch_.WLock();
 
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  uint32_t index = Hash(key) & dir_page->GetGlobalDepthMask();
+  BasicPageGuard dir_guard;
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage(&dir_guard);
+  uint32_t index = KeyToDirectoryIndex(key, dir_page);
   page_id_t bucket_page_id = dir_page->GetBucketPageId(index);
-  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
-  page->WLatch();
-  page->WUnlatch();
+  BasicPageGuard bucket_guard;
+  HASH_TABLE_BUCKET_TYPE *bucket_page = FetchBucketPage(bucket_page_id, &bucket_guard);
+  // Wait for operations that fetched the bucket before the table latch was taken; later ones can't reach it.
+  bucket_guard.GetPage()->WLatch();
+  bucket_guard.GetPage()->WUnlatch();
 
-  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
   bool is_insert = false;
-  bool is_dir_dirty = false;
 
   if (!bucket_page->IsExist(key, value, comparator_)) {
     while (bucket_page->IsFull()) {
       page_id_t image_bucket_page_id;
-      Page *image_page = buffer_pool_manager_->NewPage(&image_bucket_page_id);
-      auto image_bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(image_page->GetData());
+      BasicPageGuard image_guard = buffer_pool_manager_->NewPageGuarded(&image_bucket_page_id);
+      auto image_bucket_page = image_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
       uint32_t image_index = index ^ (1 << dir_page->GetLocalDepth(index));
 
       dir_page->IncrLocalDepth(index);
@@ -191,6 +175,7 @@ auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
       std::vector<MappingType> result;
       bucket_page->GetAllPairs(&result);
       bucket_page->Clear();
+      bucket_guard.SetDirty();
 
       for (auto &&[k, v] : result) {
         if ((Hash(k) & mask) == index) {
@@ -201,23 +186,24 @@ auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
       }
 
       page_id_t to_insert_page_id = dir_page->GetBucketPageId(Hash(key) & mask);
-      if (to_insert_page_id == bucket_page_id) {
-        buffer_pool_manager_->UnpinPage(image_bucket_page_id, true);
-      } else {
-        buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+      if (to_insert_page_id != bucket_page_id) {
         index = image_index;
         bucket_page_id = image_bucket_page_id;
         bucket_page = image_bucket_page;
+        bucket_guard = std::move(image_guard);
       }
 
-      is_dir_dirty = true;
+      dir_guard.SetDirty();
     }
 
     is_insert = bucket_page->MyInsert(key, value, comparator_);
+    if (is_insert) {
+      bucket_guard.SetDirty();
+    }
   }
 
-  buffer_pool_manager_->UnpinPage(bucket_page_id, is_insert);
-  buffer_pool_manager_->UnpinPage(directory_page_id_, is_dir_dirty);
+  bucket_guard.Drop();
+  dir_guard.Drop();
   table_latch_.WUnlock();
 
   return is_insert;
@@ -230,29 +216,31 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
   table_latch_.RLock();
 
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  uint32_t index = Hash(key) & dir_page->GetGlobalDepthMask();
-  page_id_t bucket_page_id = dir_page->GetBucketPageId(index);
-  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
-  page->WLatch();
-
-  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
-  table_latch_.RUnlock();
+  BasicPageGuard dir_guard;
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage(&dir_guard);
+  uint32_t index = KeyToDirectoryIndex(key, dir_page);
+  WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(dir_page->GetBucketPageId(index));
 
-  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket_guard.GetPage()->GetData());
   bool is_remove = bucket_page->MyRemove(key, value, comparator_);
-
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(bucket_page_id, is_remove);
+  bool is_merge = false;
 
   if (is_remove) {
+    bucket_guard.SetDirty();
+
+    // Decided while the directory and the bucket are still pinned; Merge checks again under the table write latch.
     uint32_t local_depth = dir_page->GetLocalDepth(index);
     uint32_t high_bit = local_depth > 0 ? 1 << (local_depth - 1) : 0;
     uint32_t image_index = index ^ high_bit;
+    is_merge = local_depth > 0 && dir_page->GetLocalDepth(image_index) == local_depth && bucket_page->IsEmpty();
+  }
 
-    if (local_depth > 0 && dir_page->GetLocalDepth(image_index) == local_depth && bucket_page->IsEmpty()) {
-      Merge(transaction, key, value);
-    }
+  bucket_guard.Drop();
+  dir_guard.Drop();
+  table_latch_.RUnlock();
+
+  if (is_merge) {
+    Merge(transaction, key, value);
   }
 
   return is_remove;
@@ -265,14 +253,12 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
   table_latch_.WLock();
 
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  uint32_t index = Hash(key) & dir_page->GetGlobalDepthMask();
+  BasicPageGuard dir_guard;
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage(&dir_guard);
+  uint32_t index = KeyToDirectoryIndex(key, dir_page);
   page_id_t bucket_page_id = dir_page->GetBucketPageId(index);
-  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
-  page->WLatch();
-
-  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
-  bool is_merge = false;
+  WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(bucket_page_id);
+  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket_guard.GetPage()->GetData());
 
   uint32_t local_depth = dir_page->GetLocalDepth(index);
   uint32_t high_bit = local_depth > 0 ? 1 << (local_depth - 1) : 0;
@@ -295,25 +281,21 @@ void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const
     }
 
     dir_page->CanShrink();
+    dir_guard.SetDirty();
 
-    page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    bucket_guard.Drop();
     buffer_pool_manager_->DeletePage(bucket_page_id);
 
     bucket_page_id = image_bucket_page_id;
-    page = buffer_pool_manager_->FetchPage(bucket_page_id);
-    page->WLatch();
-    bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+    bucket_guard = buffer_pool_manager_->FetchPageWrite(bucket_page_id);
+    bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket_guard.GetPage()->GetData());
 
     high_bit = local_depth > 0 ? 1 << (local_depth - 1) : 0;
     image_index = index ^ high_bit;
-
-    is_merge = true;
   }
 
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
-  buffer_pool_manager_->UnpinPage(directory_page_id_, is_merge);
+  bucket_guard.Drop();
+  dir_guard.Drop();
   table_latch_.WUnlock();
 }
 
@@ -323,9 +305,10 @@ void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetGlobalDepth() -> uint32_t {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  BasicPageGuard dir_guard;
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage(&dir_guard);
   uint32_t global_depth = dir_page->GetGlobalDepth();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  dir_guard.Drop();
   table_latch_.RUnlock();
   return global_depth;
 }
@@ -336,9 +319,10 @@ auto HASH_TABLE_TYPE::GetGlobalDepth() -> uint32_t {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::VerifyIntegrity() {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  BasicPageGuard dir_guard;
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage(&dir_guard);
   dir_page->VerifyIntegrity();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  dir_guard.Drop();
   table_latch_.RUnlock();
 }
 
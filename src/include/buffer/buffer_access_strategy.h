@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * BufferAccessStrategy lets a bulk operation, such as a large sequential scan, read through a small ring of frames
+ * instead of competing with the rest of the workload for the whole buffer pool. When a page fetched through the
+ * strategy is not in the buffer pool, the frame of the page fetched ring-size misses ago is reused if nobody has it
+ * pinned. Pages fetched through the strategy are not promoted in the replacer.
+ *
+ * A strategy belongs to a single scan; it is safe to use from the scan and its read-ahead at the same time.
+ */
+class BufferAccessStrategy {
+  friend class BufferPoolManagerInstance;
+
+ public:
+  /**
+   * Creates a new BufferAccessStrategy.
+   * @param ring_size the number of frames the scan cycles through in every buffer pool instance
+   */
+  explicit BufferAccessStrategy(size_t ring_size = SCAN_RING_SIZE) : ring_size_(ring_size) {}
+
+  /** @return the number of frames the scan cycles through in every buffer pool instance */
+  auto GetRingSize() const -> size_t { return ring_size_; }
+
+ private:
+  struct Ring {
+    /** The pages the scan brought into the buffer pool instance, INVALID_PAGE_ID for unused slots. */
+    std::vector<page_id_t> page_ids_;
+    /** The slot that is recycled next. */
+    size_t next_{0};
+  };
+
+  /**
+   * @param instance_index the index of a buffer pool instance
+   * @param ring_size the size of the ring if it has to be created
+   * @return the ring of the strategy in the buffer pool instance; only use it under the instance latch
+   */
+  auto GetRing(uint32_t instance_index, size_t ring_size) -> Ring & {
+    std::scoped_lock latch(latch_);
+    auto [iter, inserted] = rings_.try_emplace(instance_index);
+    if (inserted) {
+      iter->second.page_ids_.resize(ring_size, INVALID_PAGE_ID);
+    }
+    return iter->second;
+  }
+
+  size_t ring_size_;
+  std::unordered_map<uint32_t, Ring> rings_;
+  std::mutex latch_;
+};
+
+}  // namespace bustub
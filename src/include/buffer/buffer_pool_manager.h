@@ -15,11 +15,15 @@
 #include <list>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_stats.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -84,9 +88,100 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetch the requested page like FetchPage does, but on a miss reuse a frame of the strategy's ring, and do not
+   * promote the page in the replacer.
+   * @param page_id id of page to be fetched
+   * @param strategy the buffer access strategy of the scan, nullptr to fetch the page normally
+   * @return the requested page
+   */
+  auto FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+    return FetchPgWithStrategyImp(page_id, strategy);
+  }
+
+  /**
+   * Fetch several pages at once. Pages that are not in the buffer pool are read from disk together, and every
+   * returned page is pinned.
+   * @param page_ids ids of the pages to be fetched
+   * @param strategy the buffer access strategy of the scan, nullptr to fetch the pages normally
+   * @return the requested pages in the order of page_ids, with nullptr for pages that could not be fetched
+   */
+  auto FetchPages(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy = nullptr)
+      -> std::vector<Page *> {
+    return FetchPgsImp(page_ids, strategy);
+  }
+
+  /**
+   * Hint that the given pages will be fetched soon. Pages that are not in the buffer pool are read in together,
+   * but nothing is left pinned.
+   * @param page_ids ids of the pages to be prefetched
+   * @param strategy the buffer access strategy of the scan, nullptr to prefetch the pages normally
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy = nullptr) {
+    for (Page *page : FetchPgsImp(page_ids, strategy)) {
+      if (page != nullptr) {
+        UnpinPgImp(page->GetPageId(), false);
+      }
+    }
+  }
+
+  /**
+   * Fetch the requested page and pin it for as long as the returned guard lives.
+   * @param page_id id of page to be fetched
+   * @param strategy the buffer access strategy of the scan, nullptr to fetch the page normally
+   * @return a guard of the requested page, empty if the page could not be fetched
+   */
+  auto FetchPageBasic(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) -> BasicPageGuard {
+    return {this, FetchPgWithStrategyImp(page_id, strategy)};
+  }
+
+  /**
+   * Fetch the requested page, and pin and read-latch it for as long as the returned guard lives.
+   * @param page_id id of page to be fetched
+   * @param strategy the buffer access strategy of the scan, nullptr to fetch the page normally
+   * @return a guard of the requested page, empty if the page could not be fetched
+   */
+  auto FetchPageRead(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) -> ReadPageGuard {
+    Page *page = FetchPgWithStrategyImp(page_id, strategy);
+    if (page != nullptr) {
+      page->RLatch();
+    }
+    return {this, page};
+  }
+
+  /**
+   * Fetch the requested page, and pin and write-latch it for as long as the returned guard lives.
+   * @param page_id id of page to be fetched
+   * @param strategy the buffer access strategy of the scan, nullptr to fetch the page normally
+   * @return a guard of the requested page, empty if the page could not be fetched
+   */
+  auto FetchPageWrite(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) -> WritePageGuard {
+    Page *page = FetchPgWithStrategyImp(page_id, strategy);
+    if (page != nullptr) {
+      page->WLatch();
+    }
+    return {this, page};
+  }
+
+  /**
+   * Create a new page and pin it for as long as the returned guard lives. The page is unpinned dirty.
+   * @param[out] page_id id of created page
+   * @return a guard of the new page, empty if no new page could be created
+   */
+  auto NewPageGuarded(page_id_t *page_id) -> BasicPageGuard {
+    BasicPageGuard guard{this, NewPgImp(page_id)};
+    if (guard.IsValid()) {
+      guard.SetDirty();
+    }
+    return guard;
+  }
+
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
+  /** @return the statistics of the buffer pool since it was created */
+  virtual auto GetStats() -> BufferPoolStats = 0;
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -108,6 +203,33 @@ class BufferPoolManager {
    */
   virtual auto FetchPgImp(page_id_t page_id) -> Page * = 0;
 
+  /**
+   * Fetch the requested page from the buffer pool through a buffer access strategy. The default implementation
+   * ignores the strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the buffer access strategy, nullptr to fetch the page normally
+   * @return the requested page
+   */
+  virtual auto FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+    return FetchPgImp(page_id);
+  }
+
+  /**
+   * Fetch several pages from the buffer pool. The default implementation fetches them one at a time.
+   * @param page_ids ids of the pages to be fetched
+   * @param strategy the buffer access strategy, nullptr to fetch the pages normally
+   * @return the requested pages, nullptr for pages that could not be fetched
+   */
+  virtual auto FetchPgsImp(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy)
+      -> std::vector<Page *> {
+    std::vector<Page *> pages;
+    pages.reserve(page_ids.size());
+    for (page_id_t page_id : page_ids) {
+      pages.push_back(FetchPgWithStrategyImp(page_id, strategy));
+    }
+    return pages;
+  }
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -116,6 +238,14 @@ class BufferPoolManager {
    */
   virtual auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool = 0;
 
+  /**
+   * Unpin a page the caller holds a pin on. Page guards unpin through this, so that buffer pools can find the frame
+   * from the page itself instead of looking the page id up again. The default implementation unpins by page id.
+   * @param page a page pinned by the caller
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   */
+  virtual void UnpinGuardedPgImp(Page *page, bool is_dirty) { UnpinPgImp(page->GetPageId(), is_dirty); }
+
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
@@ -141,5 +271,8 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+ private:
+  friend class BasicPageGuard;
 };
 }  // namespace bustub
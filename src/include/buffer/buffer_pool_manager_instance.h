@@ -12,12 +12,21 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>  // NOLINT
 #include <list>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/two_q_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -27,7 +36,7 @@ namespace bustub {
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
-class BufferPoolManagerInstance : public BufferPoolManager {
+class BufferPoolManagerInstance final : public BufferPoolManager {
   friend class ParallelBufferPoolManager;
 
  public:
@@ -36,8 +45,11 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of the buffer pool
+   * @param max_pool_size the size the buffer pool can grow to with Resize, 0 to keep it at pool_size
    */
-  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU, size_t max_pool_size = 0);
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
@@ -45,9 +57,12 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param instance_index index of this BPI in the parallel BPM
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of the buffer pool
+   * @param max_pool_size the size the buffer pool can grow to with Resize, 0 to keep it at pool_size
    */
   BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                            DiskManager *disk_manager, LogManager *log_manager = nullptr);
+                            DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU, size_t max_pool_size = 0);
 
   /**
    * Destroys an existing BufferPoolManagerInstance.
@@ -57,6 +72,36 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @return size of the buffer pool */
   auto GetPoolSize() -> size_t override { return pool_size_; }
 
+  /** @return the size the buffer pool can grow to */
+  auto GetMaxPoolSize() const -> size_t { return max_pool_size_; }
+
+  /**
+   * Grow or shrink the buffer pool while it is in use. Growing hands out frames of the memory reserved at
+   * construction. Shrinking retires the frames at the end of the pool: their pages are written back if dirty and
+   * evicted, and their memory is returned to the operating system.
+   * @param pool_size the new size of the buffer pool, at least 1 and at most GetMaxPoolSize()
+   * @return false if a frame to retire holds a pinned page, in which case the pool is left as it was
+   */
+  auto Resize(size_t pool_size) -> bool;
+
+  /**
+   * @return the number of frames that are free or hold an unpinned page. Frames the page cleaner is writing count as
+   * unpinned, since eviction waits for them. Reading it takes no latch, so it may be stale by the time it is used.
+   */
+  auto GetUnpinnedFrameCount() const -> size_t;
+
+  /** @return the statistics of this instance since it was created */
+  auto GetStats() -> BufferPoolStats override;
+
+  /**
+   * Make the page cleaner run a pass now, and wait until a pass that started after this call is done. Without a page
+   * cleaner, the pass runs on the calling thread.
+   */
+  void CleanNow();
+
+  /** @return the NUMA node the memory of this instance is bound to, -1 if it is not bound to a node */
+  auto GetNumaNode() const -> int { return numa_node_; }
+
   /** @return pointer to all the pages in the buffer pool */
   auto GetPages() -> Page * { return pages_; }
 
@@ -68,6 +113,24 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto FetchPgImp(page_id_t page_id) -> Page * override;
 
+  /**
+   * Fetch the requested page from the buffer pool through a buffer access strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the buffer access strategy, nullptr to fetch the page normally
+   * @return the requested page
+   */
+  auto FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * Fetch several pages from the buffer pool. All misses are assigned frames first and then read with a single
+   * DiskManager::ReadPages call, without holding latch_.
+   * @param page_ids ids of the pages to be fetched
+   * @param strategy the buffer access strategy, nullptr to fetch the pages normally
+   * @return the requested pages, nullptr for pages that could not be fetched
+   */
+  auto FetchPgsImp(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy)
+      -> std::vector<Page *> override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -76,6 +139,21 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
 
+  /**
+   * Unpin a page the caller holds a pin on, finding its frame from the page itself.
+   * @param page a page pinned by the caller
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   */
+  void UnpinGuardedPgImp(Page *page, bool is_dirty) override;
+
+  /**
+   * Unpin the page in a frame. Caller must hold the page table partition latch of the page.
+   * @param frame_id id of the frame to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  auto UnpinFrame(frame_id_t frame_id, bool is_dirty) -> bool;
+
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
@@ -98,23 +176,194 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   auto DeletePgImp(page_id_t page_id) -> bool override;
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Flushes all the pages in the buffer pool to disk, and syncs the database file.
    */
   void FlushAllPgsImp() override;
 
   /**
-   * Allocate a page on disk.∂
+   * Write back every dirty page in page id order, coalescing consecutive pages into vectored writes, without syncing
+   * the database file. The pages are pinned while they are written instead of holding any latch, so the buffer pool
+   * keeps serving requests; pages dirtied meanwhile stay dirty.
+   */
+  void WriteBackDirtyPages();
+
+  /**
+   * Write back pages that the caller pinned and marked clean, in page id order, and unpin them again. If the write
+   * fails, the pages are marked dirty again.
+   * @param pages the page ids and frames of the pages
+   */
+  void WriteBackPinnedPages(std::vector<std::pair<page_id_t, frame_id_t>> *pages);
+
+  /**
+   * Pin the page if it is already resident. Only the page table partition latch of page_id is taken. If the page is
+   * still being read from disk, waits until it is loaded.
+   * @param page_id id of page to be pinned
+   * @param record_access false if the access should not count towards the replacement policy
+   * @return the pinned page, nullptr if the page is not in the buffer pool
+   */
+  auto PinResidentPage(page_id_t page_id, bool record_access = true) -> Page *;
+
+  /**
+   * Hand a frame whose last pin was just released back to the replacer, cold if it was pinned through a buffer access
+   * strategy. Caller must hold the page table partition latch of the page in the frame.
+   * @param frame_id id of the unpinned frame
+   */
+  void UnpinReplacer(frame_id_t frame_id);
+
+  /**
+   * @param page_id id of the page
+   * @return true if the page is in the page table, possibly still being read from disk
+   */
+  auto IsResident(page_id_t page_id) -> bool;
+
+  /**
+   * Publish a frame assigned to page_id in the page table before its data is read, so that other fetches of the page
+   * wait for the read instead of loading it again. Caller must hold latch_ and a pin on the frame.
+   * @param page_id id of the page being read
+   * @param frame_id id of the frame the page is read into
+   */
+  void StartLoading(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Complete a read started with StartLoading and wake up the fetches waiting for it. Caller must not hold latch_.
+   * @param page_id id of the page that was read
+   * @param frame_id id of the frame the page was read into
+   * @param loaded true if the read succeeded; otherwise the page is dropped and the frame goes back to the free list
+   */
+  void FinishLoading(page_id_t page_id, frame_id_t frame_id, bool loaded);
+
+  /** The misses of a batch fetch, which were assigned frames and are read without holding latch_. */
+  struct PendingFetch {
+    /** The pages being read into their frames. */
+    std::unordered_map<page_id_t, frame_id_t> loading_;
+    /** The arguments of the DiskManager::ReadPages call that loads them. */
+    std::vector<page_id_t> read_ids_;
+    std::vector<char *> read_buffers_;
+    /** Positions of pages that another thread was loading. They are fetched one by one after the batch is read. */
+    std::vector<size_t> deferred_;
+  };
+
+  /**
+   * First half of a batch fetch: pin the resident pages, and assign frames to the misses and start loading them.
+   * @param page_ids ids of the pages to be fetched
+   * @param strategy the buffer access strategy, nullptr to fetch the pages normally
+   * @param[out] pages the pinned pages, including the ones still to be read
+   * @return the reads the caller has to do before calling EndFetchPages
+   */
+  auto BeginFetchPages(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy,
+                       std::vector<Page *> *pages) -> PendingFetch;
+
+  /**
+   * Second half of a batch fetch, after the reads of BeginFetchPages. If they failed, every page is unpinned again.
+   * Otherwise, the loaded pages are published and the deferred pages are fetched; if that throws, pages keeps
+   * nullptr for the deferred pages that could not be fetched.
+   * @param page_ids ids of the pages to be fetched
+   * @param strategy the buffer access strategy, nullptr to fetch the pages normally
+   * @param fetch the state returned by BeginFetchPages
+   * @param loaded true if the reads succeeded
+   * @param[in,out] pages the pages returned by BeginFetchPages
+   */
+  void EndFetchPages(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy, PendingFetch *fetch,
+                     bool loaded, std::vector<Page *> *pages);
+
+  /**
+   * Take a frame from the free list, or evict a victim from the replacer. Caller must hold latch_.
+   * @param[out] frame_id id of the frame that can be reused
+   * @return false if all frames are pinned, true otherwise
+   */
+  auto GetFreeFrame(frame_id_t *frame_id) -> bool;
+
+  /**
+   * Take a frame for page_id. With a strategy, the frame of the page in the next slot of the strategy's ring is
+   * reused if nobody has it pinned, and page_id takes over the slot. Caller must hold latch_.
+   * @param page_id id of the page the frame is for
+   * @param strategy the buffer access strategy, nullptr to only use GetFreeFrame
+   * @param[out] frame_id id of the frame that can be reused
+   * @return false if all frames are pinned, true otherwise
+   */
+  auto GetFrame(page_id_t page_id, BufferAccessStrategy *strategy, frame_id_t *frame_id) -> bool;
+
+  /**
+   * Evict page_id from its frame if it is resident and unpinned. Caller must hold latch_.
+   * @param page_id id of the page to evict
+   * @param[out] frame_id id of the frame that can be reused
+   * @return true if the page was evicted, false otherwise
+   */
+  auto ReclaimFrame(page_id_t page_id, frame_id_t *frame_id) -> bool;
+
+  /**
+   * Acquire latch_, adding the time spent waiting for it to the statistics. An uncontended latch costs no clock reads.
+   * @return the held latch
+   */
+  auto LockLatch() -> std::unique_lock<std::mutex>;
+
+  /** @return the number of frames holding a pinned page, summed over the page table partitions without a latch */
+  auto GetPinnedFrameCount() const -> size_t;
+
+  /**
+   * Raise the pinned frames high-water mark to the number of pinned frames if needed. Called when a frame is assigned
+   * to a page, rather than on every pin, so that hits don't write state shared by the whole instance.
+   */
+  void UpdatePinnedFramesHighWater();
+
+  /**
+   * Page cleaner thread body. Sleeps until eviction runs into dirty victims or CleanNow asks for a pass, and cleans
+   * frames until it is stopped. An instance that never evicts a dirty page never wakes it.
+   */
+  void RunPageCleaner();
+
+  /** Wake up the page cleaner for a pass, e.g. because eviction ran into dirty victims. */
+  void WakePageCleaner();
+
+  /**
+   * Wait until the page cleaner is done with the pass it is running or was asked for, and with the frames that pass
+   * pinned.
+   * @return false if the page cleaner was idle, or there is none
+   */
+  auto WaitForPageCleaner() -> bool;
+
+  /**
+   * Write back dirty unpinned frames until at least a quarter of the frames are clean and unpinned. The frames are
+   * pinned while they are written instead of holding their page table partition latch, so that hits on the partition
+   * don't wait for the disk. Does nothing once the disk manager is shut down.
+   */
+  void CleanFrames();
+
+  /** Statistics logger thread body. Logs the statistics every buffer_pool_stats_interval until it is stopped. */
+  void RunStatsLogger();
+
+  /** Number of partitions the page table is split into. */
+  static constexpr size_t PAGE_TABLE_PARTITIONS = 16;
+
+  /** A partition of the page table, guarded by its own latch. Partitions don't share cache lines. */
+  struct alignas(CACHE_LINE_SIZE) PageTablePartition {
+    /** Protects table_ and the pin count / dirty flag of the frames it maps to. */
+    std::mutex latch_;
+    std::unordered_map<page_id_t, frame_id_t> table_;
+    /** Signalled when a page of the partition has been read from disk, or its read failed. */
+    std::condition_variable loaded_cv_;
+    /** Resident-page hits on the partition, counted under its latch so that hits don't share a counter. */
+    std::atomic<uint64_t> hits_{0};
+    /** Frames holding a pinned page of the partition, counted under its latch like hits_. */
+    std::atomic<size_t> pinned_frames_{0};
+  };
+
+  /** @return the page table partition responsible for page_id */
+  auto GetPartition(page_id_t page_id) -> PageTablePartition & {
+    return page_table_[(page_id / num_instances_) % PAGE_TABLE_PARTITIONS];
+  }
+
+  /**
+   * Allocate a page on disk, reusing the id of a deallocated page if there is one the pool holds no copy of.
    * @return the id of the allocated page
    */
   auto AllocatePage() -> page_id_t;
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, recording it in the free-space map of the disk manager.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
 
   /**
    * Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
@@ -123,8 +372,10 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   void ValidatePageId(page_id_t page_id) const;
 
-  /** Number of pages in the buffer pool. */
-  const size_t pool_size_;
+  /** Number of pages in the buffer pool. Frames pool_size_ and above are retired; changes only under latch_. */
+  std::atomic<size_t> pool_size_;
+  /** Number of frames memory is reserved for. */
+  const size_t max_pool_size_;
   /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
   const uint32_t num_instances_ = 1;
   /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
@@ -132,19 +383,61 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** Each BPI maintains its own counter for page_ids to hand out, must ensure they mod back to its instance_index_ */
   std::atomic<page_id_t> next_page_id_ = instance_index_;
 
-  /** Array of buffer pool pages. */
+  /** NUMA node pages_ and frame_data_ are bound to, -1 if enable_numa_placement was false at construction. */
+  const int numa_node_;
+  /** Array of buffer pool pages, with room for max_pool_size_ pages. */
   Page *pages_;
+  /** Size of the mapping behind pages_. */
+  size_t pages_size_;
+  /** PAGE_SIZE aligned memory holding the data of every frame, pages_[i] uses the i-th PAGE_SIZE block. */
+  char *frame_data_;
+  /** Size of the mapping behind frame_data_, rounded up to the huge page size if huge pages are used. Only the frames
+   * in use are backed by memory. */
+  size_t frame_data_size_;
+  /** True if frame_data_ is backed by reserved huge pages, which can only be returned to the system whole. */
+  bool frame_data_huge_pages_{false};
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  /** Page table for keeping track of buffer pool pages, partitioned so that resident-page hits do not contend. */
+  std::array<PageTablePartition, PAGE_TABLE_PARTITIONS> page_table_;
   /** Replacer to find unpinned pages for replacement. */
   Replacer *replacer_;
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /**
+   * This latch serializes frame (re)assignment: it protects free_list_ and the miss, new and delete paths.
+   * Resident-page fetch and unpin never take it. Lock order is latch_ before any page table partition latch.
+   */
   std::mutex latch_;
+
+  /** Background page cleaner, nullptr if enable_page_cleaner was false when this instance was created. */
+  std::thread *page_cleaner_thread_{nullptr};
+  /** Protects the page cleaner state below and is used to wake up the page cleaner. */
+  std::mutex cleaner_latch_;
+  std::condition_variable cleaner_cv_;
+  bool stop_cleaner_{false};
+  /** True if CleanNow is waiting for a pass that has not started yet. */
+  bool clean_requested_{false};
+  uint64_t cleaner_passes_started_{0};
+  uint64_t cleaner_passes_done_{0};
+  /** Notified whenever a page cleaner pass is done. */
+  std::condition_variable cleaner_done_cv_;
+  /** Frames the page cleaner has pinned to write them back. */
+  std::atomic<size_t> cleaner_pinned_frames_{0};
+
+  /** Statistics of the miss, eviction and write-back paths. Hits are counted per page table partition. */
+  std::atomic<uint64_t> misses_{0};
+  std::atomic<uint64_t> evictions_{0};
+  std::atomic<uint64_t> dirty_writebacks_{0};
+  std::atomic<int64_t> latch_wait_ns_{0};
+  std::atomic<size_t> pinned_frames_high_water_{0};
+  /** Background statistics logger, nullptr if enable_buffer_pool_stats_logging was false at construction. */
+  std::thread *stats_logger_thread_{nullptr};
+  /** Protects stop_stats_logger_ and is used to wake up the statistics logger. */
+  std::mutex stats_logger_latch_;
+  std::condition_variable stats_logger_cv_;
+  bool stop_stats_logger_{false};
 };
 }  // namespace bustub
@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace bustub {
+
+/**
+ * BufferPoolStats is a snapshot of what a buffer pool has been doing since it was created. The counters are read
+ * without stopping the buffer pool, so a snapshot taken under load is not exact, but every counter only grows.
+ */
+struct BufferPoolStats {
+  /** Fetches of pages that were already in the buffer pool. */
+  uint64_t hits_{0};
+  /** Fetches of pages that had to be read from disk. */
+  uint64_t misses_{0};
+  /** Pages that were thrown out of their frame to make room for another page. */
+  uint64_t evictions_{0};
+  /** Dirty pages written back by eviction or by the page cleaner. Explicit flushes are not counted. */
+  uint64_t dirty_writebacks_{0};
+  /** Time spent waiting for the frame assignment latch of the buffer pool. */
+  std::chrono::nanoseconds latch_wait_time_{0};
+  /** The largest number of frames that were pinned at the same time, as seen whenever a frame got a page. */
+  uint64_t pinned_frames_high_water_{0};
+
+  /** @return the fraction of fetches that hit the buffer pool, 0 if nothing was fetched */
+  auto HitRatio() const -> double {
+    uint64_t fetches = hits_ + misses_;
+    return fetches == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(fetches);
+  }
+
+  /**
+   * Add the counters of another buffer pool to these. The high-water mark is summed as well, which overestimates
+   * it for pools whose instances did not peak at the same time.
+   */
+  auto operator+=(const BufferPoolStats &other) -> BufferPoolStats & {
+    hits_ += other.hits_;
+    misses_ += other.misses_;
+    evictions_ += other.evictions_;
+    dirty_writebacks_ += other.dirty_writebacks_;
+    latch_wait_time_ += other.latch_wait_time_;
+    pinned_frames_high_water_ += other.pinned_frames_high_water_;
+    return *this;
+  }
+
+  /** @return a one-line summary of the counters */
+  auto ToString() const -> std::string {
+    std::ostringstream os;
+    os << "hits: " << hits_ << ", misses: " << misses_ << ", hit ratio: " << HitRatio()
+       << ", evictions: " << evictions_ << ", dirty write-backs: " << dirty_writebacks_
+       << ", latch wait: " << std::chrono::duration_cast<std::chrono::microseconds>(latch_wait_time_).count()
+       << "us, pinned frames high-water: " << pinned_frames_high_water_;
+    return os.str();
+  }
+};
+
+}  // namespace bustub
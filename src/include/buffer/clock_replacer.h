@@ -12,8 +12,7 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
+#include <atomic>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -23,6 +22,11 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * The state of every frame is an evictable bit and a reference bit, packed next to each other into a contiguous
+ * array of atomic words. Pin and Unpin are a single atomic and/or on the word of the frame, and Victim claims a frame
+ * with a compare-and-swap, so no operation takes a latch, allocates or looks up a hash table. A cold unpin leaves the
+ * reference bit clear, so the hand takes the frame on its next pass.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -43,10 +47,30 @@ class ClockReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void UnpinCold(frame_id_t frame_id) override;
+
   auto Size() -> size_t override;
 
  private:
-  // TODO(student): implement me!
+  /** Every word holds the two bits of FRAMES_PER_WORD frames. */
+  static constexpr size_t FRAMES_PER_WORD = 32;
+  static constexpr uint64_t EVICTABLE_BIT = 1;
+  static constexpr uint64_t REFERENCE_BIT = 2;
+
+  /** @return the bits of frame_id at the position they occupy in its word */
+  static auto FrameBits(frame_id_t frame_id, uint64_t bits) -> uint64_t {
+    return bits << (2 * (static_cast<size_t>(frame_id) % FRAMES_PER_WORD));
+  }
+
+  /** @return the word holding the bits of frame_id */
+  auto FrameWord(frame_id_t frame_id) -> std::atomic<uint64_t> & {
+    return frames_[static_cast<size_t>(frame_id) / FRAMES_PER_WORD];
+  }
+
+  size_t num_frames_;
+  std::vector<std::atomic<uint64_t>> frames_;
+  /** Position of the clock hand, taken modulo num_frames_. */
+  std::atomic<size_t> hand_{0};
 };
 
 }  // namespace bustub
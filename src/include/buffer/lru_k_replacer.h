@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The victim is the frame whose K-th most recent access lies furthest in the past. Frames with fewer than K
+ * accesses have an infinite backward K-distance and are evicted first, oldest first access first, so pages that a
+ * scan touches only once cannot push out pages that are accessed repeatedly.
+ *
+ * Back-to-back accesses of a thread to the same frame, e.g. a scan fetching the same page for every tuple, form one
+ * correlated reference and are recorded as a single access.
+ *
+ * Every frame has a ring of atomic words holding the times of its last K accesses, an atomic access count, an atomic
+ * evictable flag and the tag of its last access, so Pin, Unpin and RecordAccess never take a latch or write state
+ * shared between frames. Victim compares VICTIM_WINDOW frames at a time, starting where the last search left off, and
+ * claims the frame with the largest backward K-distance of the first window that has an evictable frame with a
+ * compare-and-swap on its flag. A victim keeps its history until it is removed, so a victim that is pinned or unpinned
+ * again instead of being evicted keeps its place.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of accesses that are remembered for every frame
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = 2);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  auto Victim(frame_id_t *frame_id) -> bool override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+ private:
+  /** The replacement state of a frame. */
+  struct FrameState {
+    /** Number of accesses recorded since the frame was last removed. */
+    std::atomic<uint64_t> num_accesses_{0};
+    /** Tag of the last access, see IsCorrelatedAccess. */
+    std::atomic<uint64_t> last_reference_{0};
+    std::atomic<bool> evictable_{false};
+  };
+
+  /** @return true if frame_id is a frame of this replacer */
+  auto IsValid(frame_id_t frame_id) const -> bool {
+    return frame_id >= 0 && static_cast<size_t>(frame_id) < capacity_;
+  }
+
+  /** @return the time of the i-th access of a frame, modulo k, i.e. the slot of the ring the access is recorded in */
+  auto AccessTime(frame_id_t frame_id, uint64_t i) -> std::atomic<uint64_t> & {
+    return access_times_[static_cast<size_t>(frame_id) * k_ + i % k_];
+  }
+
+  size_t capacity_;
+  size_t k_;
+  std::vector<FrameState> frames_;
+  /** The last k access times of every frame, k consecutive words per frame. */
+  std::vector<std::atomic<uint64_t>> access_times_;
+  /** Where the next victim search starts, taken modulo capacity_. */
+  std::atomic<size_t> hand_{0};
+};
+
+}  // namespace bustub
@@ -12,9 +12,7 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
-#include <unordered_map>
+#include <atomic>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -23,7 +21,15 @@
 namespace bustub {
 
 /**
- * LRUReplacer implements the Least Recently Used replacement policy.
+ * LRUReplacer implements the Least Recently Used replacement policy, approximated by a clock with several chances.
+ *
+ * Every frame has an atomic word holding the number of clock hand passes it survives before it is evicted, 0 while it
+ * is pinned. Unpin gives a frame all of its chances and a cold unpin none, so Pin and Unpin are a single atomic
+ * operation on the word of the frame, and the buffer pool can call them on its hit path without taking a latch or
+ * touching any state shared with other frames. Victim advances the hand, taking a chance from every evictable frame
+ * it passes, and claims the first frame without one left with a compare-and-swap. A frame unpinned recently has been
+ * passed fewer times than one unpinned long ago, so the victim is close to the least recently used frame, and finding
+ * it costs a bounded number of steps per eviction on average instead of a scan of the pool.
  */
 class LRUReplacer : public Replacer {
  public:
@@ -44,14 +50,21 @@ class LRUReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void UnpinCold(frame_id_t frame_id) override;
+
   auto Size() -> size_t override;
 
  private:
-  // TODO(student): implement me!
+  /** Hand passes an unpinned frame survives. Cold frames are evicted at the first pass. */
+  static constexpr uint8_t CHANCES = 3;
+  /** The value of an evictable frame word without chances left. Pinned frames hold 0. */
+  static constexpr uint8_t LAST_CHANCE = 1;
+
   size_t capacity_;
-  std::list<frame_id_t> lst_;
-  std::unordered_map<frame_id_t, std::list<frame_id_t>::iterator> mp_;
-  std::mutex latch_;
+  /** The chances every frame has left plus one, 0 if it is not evictable. */
+  std::vector<std::atomic<uint8_t>> frames_;
+  /** Position of the clock hand, taken modulo capacity_. */
+  std::atomic<size_t> hand_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/mmap_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * MmapBufferPoolManager serves a database file that does not change while it is open, e.g. on a read replica. The
+ * whole file is mapped read-only, and every page of it is resident for the lifetime of the buffer pool, with its data
+ * pointing straight into the mapping. Fetching a page is an array lookup: nothing is copied, and there is no page
+ * table, replacer or pin count to maintain. The operating system pages the file in and out as it sees fit. Page
+ * objects are only created when a page near them is first fetched, so a large file costs little memory up front.
+ *
+ * Pages must not be modified: writing to their data crashes, unpinning them dirty fails, and no page can be created
+ * or deleted. Pages are not verified against their checksums, and compressed database files are not supported.
+ */
+class MmapBufferPoolManager final : public BufferPoolManager {
+ public:
+  /**
+   * Creates a new MmapBufferPoolManager.
+   * @param db_file the database file to map
+   * @throws Exception if the file can't be mapped or pages are stored compressed
+   */
+  explicit MmapBufferPoolManager(const std::string &db_file);
+
+  /**
+   * Destroys an existing MmapBufferPoolManager. No page may be in use any more.
+   */
+  ~MmapBufferPoolManager() override;
+
+  /** @return the number of pages in the database file */
+  auto GetPoolSize() -> size_t override { return num_pages_; }
+
+  /** @return no statistics, since fetches are not counted */
+  auto GetStats() -> BufferPoolStats override { return {}; }
+
+ protected:
+  /**
+   * Fetch the requested page.
+   * @param page_id id of page to be fetched
+   * @return the requested page, nullptr if it is not in the database file
+   */
+  auto FetchPgImp(page_id_t page_id) -> Page * override;
+
+  /**
+   * Unpin the target page. Pages stay resident all the same.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty must be false
+   * @return false if the page is not in the database file or is_dirty is true, true otherwise
+   */
+  auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
+
+  /**
+   * Pages are never dirty, so there is nothing to flush.
+   * @param page_id id of page to be flushed
+   * @return false if the page is not in the database file, true otherwise
+   */
+  auto FlushPgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * The database file is read-only, so no page can be created.
+   * @param[out] page_id set to INVALID_PAGE_ID
+   * @return nullptr
+   */
+  auto NewPgImp(page_id_t *page_id) -> Page * override;
+
+  /**
+   * The database file is read-only, so no page can be deleted.
+   * @param page_id id of page to be deleted
+   * @return false if the page is in the database file, true otherwise
+   */
+  auto DeletePgImp(page_id_t page_id) -> bool override;
+
+  /** Pages are never dirty, so there is nothing to flush. */
+  void FlushAllPgsImp() override {}
+
+ private:
+  /** Descriptor of the database file. */
+  int fd_{-1};
+  /** The mapping of the database file, nullptr if the file is empty. */
+  char *data_{nullptr};
+  /** Number of whole pages in the database file. A torn page at the end is left out. */
+  size_t num_pages_{0};
+  /**
+   * The pages of the database file in chunks of PAGES_PER_CHUNK, indexed by page id / PAGES_PER_CHUNK. A chunk is
+   * nullptr until one of its pages is fetched.
+   */
+  std::unique_ptr<std::atomic<Page *>[]> chunks_;
+
+  /** Number of pages whose Page objects are created together. */
+  static constexpr size_t PAGES_PER_CHUNK = 1024;
+
+  /** @return the pages of a chunk, which are created if no page of the chunk was fetched before */
+  auto GetChunk(size_t chunk) -> Page *;
+
+  /** @return the number of pages in a chunk; the last chunk may hold fewer than PAGES_PER_CHUNK */
+  auto GetChunkSize(size_t chunk) const -> size_t {
+    return std::min(PAGES_PER_CHUNK, num_pages_ - chunk * PAGES_PER_CHUNK);
+  }
+
+  /** Destroy the pages of a chunk and free their memory. */
+  static void DestroyChunk(Page *pages, size_t count);
+};
+
+}  // namespace bustub
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "buffer/buffer_pool_manager.h"
 #include "buffer/buffer_pool_manager_instance.h"
 #include "recovery/log_manager.h"
@@ -28,9 +30,12 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * @param pool_size the pool size of each BufferPoolManagerInstance
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of every BufferPoolManagerInstance
+   * @param max_pool_size the pool size every BufferPoolManagerInstance can grow to, 0 to keep it at pool_size
    */
   ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU,
+                            size_t max_pool_size = 0);
 
   /**
    * Destroys an existing ParallelBufferPoolManager.
@@ -40,12 +45,24 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   /** @return size of the buffer pool */
   auto GetPoolSize() -> size_t override;
 
+  /**
+   * Resize every BufferPoolManagerInstance while the buffer pool is in use. The number of instances stays the same,
+   * because page ids are routed to instances by their value.
+   * @param pool_size the new pool size of each BufferPoolManagerInstance
+   * @return false if some instance could not shrink because a frame to retire holds a pinned page, in which case every
+   * instance keeps its size
+   */
+  auto Resize(size_t pool_size) -> bool;
+
+  /** @return the statistics of all BufferPoolManagerInstances added together */
+  auto GetStats() -> BufferPoolStats override;
+
  protected:
   /**
    * @param page_id id of page
-   * @return pointer to the BufferPoolManager responsible for handling given page id
+   * @return pointer to the BufferPoolManagerInstance responsible for handling given page id
    */
-  auto GetBufferPoolManager(page_id_t page_id) -> BufferPoolManager *;
+  auto GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance *;
 
   /**
    * Fetch the requested page from the buffer pool.
@@ -54,6 +71,24 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   auto FetchPgImp(page_id_t page_id) -> Page * override;
 
+  /**
+   * Fetch the requested page from the buffer pool through a buffer access strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the buffer access strategy, nullptr to fetch the page normally
+   * @return the requested page
+   */
+  auto FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * Fetch several pages from the buffer pool. Pages are grouped by responsible instance, and instances with misses
+   * read their groups in parallel.
+   * @param page_ids ids of the pages to be fetched
+   * @param strategy the buffer access strategy, nullptr to fetch the pages normally
+   * @return the requested pages, nullptr for pages that could not be fetched
+   */
+  auto FetchPgsImp(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy)
+      -> std::vector<Page *> override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -62,6 +97,13 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
 
+  /**
+   * Unpin a page the caller holds a pin on, in the BufferPoolManagerInstance it belongs to.
+   * @param page a page pinned by the caller
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   */
+  void UnpinGuardedPgImp(Page *page, bool is_dirty) override;
+
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
@@ -84,18 +126,18 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   auto DeletePgImp(page_id_t page_id) -> bool override;
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Flushes all the pages in the buffer pool to disk. The instances write their pages back concurrently, and the
+   * database file is synced once they are all done.
    */
   void FlushAllPgsImp() override;
 
   const uint32_t num_instances_;
 
-  const size_t pool_size_;
+  DiskManager *disk_manager_;
 
   BufferPoolManagerInstance **buffer_pool_manager_instance_;
 
-  size_t start_index_;
-
-  std::mutex latch_;
+  /** NewPgImp starts looking for a frame at this instance, modulo num_instances_. */
+  std::atomic<uint32_t> next_instance_{0};
 };
 }  // namespace bustub
@@ -12,12 +12,23 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>  // NOLINT
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** The replacement policies a BufferPoolManagerInstance can be created with. */
+enum class ReplacerType { LRU, LRU_K, TWO_Q, CLOCK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
+ *
+ * The buffer pool calls Pin, Unpin and RecordAccess on its hit path, holding only the latch of a page table partition,
+ * so these may run concurrently with each other and with Victim, and should not take a replacer-wide latch. Victim
+ * and Remove are called with the buffer pool latch held. A frame handed out by Victim is either removed once its page
+ * is evicted, or unpinned again if the buffer pool keeps the page after all.
  */
 class Replacer {
  public:
@@ -43,8 +54,53 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Unpins a frame whose page is not expected to be accessed again soon, e.g. a page read by a bulk scan, so that it
+   * goes to the eviction end of the policy. Policies that already evict pages without recorded accesses first treat
+   * this as Unpin.
+   * @param frame_id the id of the frame to unpin
+   */
+  virtual void UnpinCold(frame_id_t frame_id) { Unpin(frame_id); }
+
+  /**
+   * Records that the page held by a frame was accessed. Policies that only look at pin and unpin order ignore this.
+   * @param frame_id the id of the accessed frame
+   */
+  virtual void RecordAccess(frame_id_t frame_id) {}
+
+  /**
+   * Forgets everything about a frame, indicating that it no longer holds a page.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual auto Size() -> size_t = 0;
+
+ protected:
+  /** Frames a policy that ranks frames by their history compares at a time when it looks for a victim. */
+  static constexpr size_t VICTIM_WINDOW = 64;
+
+  /** @return the time of an access now, for access histories. Reading it writes no state shared between threads. */
+  static auto Now() -> uint64_t {
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+  }
+
+  /**
+   * Tag an access of the calling thread to a frame. Back-to-back accesses of a thread to the same frame, e.g. a scan
+   * fetching the same page for every tuple, form one correlated reference. Only the frame and the calling thread are
+   * written, so recognizing them doesn't make accesses to different frames contend.
+   * @param last_reference the tag of the last access to the frame, 0 if there is none, replaced with the tag of this
+   * access
+   * @return true if the last access of the calling thread was to the same frame, false otherwise
+   */
+  static auto IsCorrelatedAccess(std::atomic<uint64_t> *last_reference) -> bool {
+    static std::atomic<uint64_t> next_thread{1};
+    // The upper bits tell the threads apart, the lower bits count the accesses of a thread.
+    thread_local uint64_t reference = next_thread.fetch_add(1) << 40;
+    uint64_t previous = reference++;
+    return last_reference->exchange(reference) == previous;
+  }
 };
 
 }  // namespace bustub
@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer.h
+//
+// Identification: src/include/buffer/two_q_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * TwoQReplacer implements the simplified 2Q replacement policy.
+ *
+ * A frame accessed for the first time enters the A1 queue, which is FIFO by first access. A second access promotes it
+ * to the Am queue, which is LRU by last access. As long as A1 holds more than a quarter of the frames, victims are
+ * taken from A1, so a scan only ever recycles A1 frames and the hot pages in Am survive it.
+ *
+ * Full 2Q also remembers the pages recently evicted from A1 in a ghost queue, A1out, and only promotes a page that is
+ * accessed again while in A1out. A replacer only knows frames, not the pages they hold, so it can't tell that a frame
+ * was reloaded with a page it just evicted, and there is no A1out: a page is promoted when it is accessed again while
+ * it is still resident in A1.
+ *
+ * Back-to-back accesses of a thread to the same frame form one correlated reference and do not promote the frame.
+ *
+ * The queues are not materialized: every frame has atomic words holding its access count, its first and last access
+ * times and its flags, so Pin, Unpin and RecordAccess never take a latch. The size of A1 is a counter that only
+ * changes when a frame enters or leaves A1, not on every access. Victim compares VICTIM_WINDOW frames at a time,
+ * starting where the last search left off, and claims the head of the chosen queue among the first window that has
+ * an evictable frame with a compare-and-swap on its evictable flag. A victim leaves A1 until it is removed, unpinned
+ * or accessed again, but keeps its history.
+ */
+class TwoQReplacer : public Replacer {
+ public:
+  /**
+   * Create a new TwoQReplacer.
+   * @param num_pages the maximum number of pages the TwoQReplacer will be required to store
+   */
+  explicit TwoQReplacer(size_t num_pages);
+
+  /**
+   * Destroys the TwoQReplacer.
+   */
+  ~TwoQReplacer() override;
+
+  auto Victim(frame_id_t *frame_id) -> bool override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+ private:
+  /** The replacement state of a frame. A frame is in A1 while it has at most one access, and in Am afterwards. */
+  struct FrameState {
+    /** Number of accesses recorded since the frame was last removed. */
+    std::atomic<uint64_t> num_accesses_{0};
+    std::atomic<uint64_t> first_access_{0};
+    std::atomic<uint64_t> last_access_{0};
+    /** Tag of the last access, see IsCorrelatedAccess. */
+    std::atomic<uint64_t> last_reference_{0};
+    std::atomic<bool> evictable_{false};
+    /** True if the frame is counted in a1_size_. */
+    std::atomic<bool> in_a1_{false};
+  };
+
+  /** @return true if frame_id is a frame of this replacer */
+  auto IsValid(frame_id_t frame_id) const -> bool {
+    return frame_id >= 0 && static_cast<size_t>(frame_id) < capacity_;
+  }
+
+  /** Count a frame in A1 unless it already is. */
+  void EnterA1(FrameState *frame) {
+    if (!frame->in_a1_.load() && !frame->in_a1_.exchange(true)) {
+      a1_size_.fetch_add(1);
+    }
+  }
+
+  /** Stop counting a frame in A1 if it is. */
+  void LeaveA1(FrameState *frame) {
+    if (frame->in_a1_.load() && frame->in_a1_.exchange(false)) {
+      a1_size_.fetch_sub(1);
+    }
+  }
+
+  size_t capacity_;
+  /** Victims come from A1 while it holds more frames than this. */
+  size_t a1_threshold_;
+  std::vector<FrameState> frames_;
+  /** Number of frames counted in A1. It may be briefly negative while a frame enters and leaves A1 concurrently. */
+  std::atomic<int64_t> a1_size_{0};
+  /** Where the next victim search starts, taken modulo capacity_. */
+  std::atomic<size_t> hand_{0};
+};
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <filesystem>
 #include <string>
 
 #include "buffer/buffer_pool_manager_instance.h"
@@ -18,21 +19,50 @@
 #include "recovery/checkpoint_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/page/header_page.h"
 
 namespace bustub {
 
 class BustubInstance {
  public:
-  explicit BustubInstance(const std::string &db_file_name) {
+  /**
+   * Open or create a database.
+   * @param db_file_name the database file
+   * @param disk_io_backend the page I/O backend of the disk manager
+   * @param buffer_pool_size the number of frames of the buffer pool
+   * @throws Exception if the database file was created with a different page size
+   */
+  explicit BustubInstance(const std::string &db_file_name, DiskIOBackend disk_io_backend = DiskIOBackend::FSTREAM,
+                          size_t buffer_pool_size = BUFFER_POOL_SIZE) {
     enable_logging = false;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    std::error_code error;
+    bool new_database = std::filesystem::file_size(db_file_name, error) == 0 || error;
+    disk_manager_ = new DiskManager(db_file_name, disk_io_backend);
 
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
-    buffer_pool_manager_ = new BufferPoolManagerInstance(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    buffer_pool_manager_ = new BufferPoolManagerInstance(buffer_pool_size, disk_manager_, log_manager_);
+
+    // the header page records the page size of new databases, and existing ones must match it
+    page_id_t header_page_id = HEADER_PAGE_ID;
+    auto *header_page = static_cast<HeaderPage *>(new_database ? buffer_pool_manager_->NewPage(&header_page_id)
+                                                               : buffer_pool_manager_->FetchPage(header_page_id));
+    if (new_database) {
+      header_page->Init();
+    }
+    try {
+      header_page->CheckPageSize();
+    } catch (const Exception &) {
+      buffer_pool_manager_->UnpinPage(header_page_id, false);
+      delete buffer_pool_manager_;
+      delete log_manager_;
+      delete disk_manager_;
+      throw;
+    }
+    buffer_pool_manager_->UnpinPage(header_page_id, true);
 
     // txn related
     lock_manager_ = new LockManager();
@@ -46,6 +76,7 @@ class BustubInstance {
     if (enable_logging) {
       log_manager_->StopFlushThread();
     }
+    buffer_pool_manager_->FlushAllPages();
     delete checkpoint_manager_;
     delete log_manager_;
     delete buffer_pool_manager_;
@@ -16,6 +16,11 @@
 #include <chrono>  // NOLINT
 #include <cstdint>
 
+/** Size of a data page in byte. Set it with -DBUSTUB_PAGE_SIZE when configuring the build. */
+#ifndef BUSTUB_PAGE_SIZE
+#define BUSTUB_PAGE_SIZE 4096
+#endif
+
 namespace bustub {
 
 /** Cycle detection is performed every CYCLE_DETECTION_INTERVAL milliseconds. */
@@ -27,14 +32,78 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/**
+ * True if every buffer pool instance should run a background page cleaner, false otherwise. The cleaner sleeps until
+ * eviction runs into dirty pages. It stops writing once the DiskManager of its instance is shut down, but the instance
+ * must still be destroyed before the DiskManager.
+ */
+extern std::atomic<bool> enable_page_cleaner;
+
+/** True if buffer pool frames should be backed by huge pages when the system provides them, false otherwise. */
+extern std::atomic<bool> enable_huge_pages;
+
+/** True if sequential table scans should read the upcoming pages of the table ahead of time, false otherwise. */
+extern std::atomic<bool> enable_readahead;
+
+/**
+ * True if the instances of a parallel buffer pool should be spread over the NUMA nodes of the machine, with their
+ * frames bound to their node and new pages created in an instance local to the calling thread, false otherwise.
+ */
+extern std::atomic<bool> enable_numa_placement;
+
+/**
+ * True if a DiskManager should keep a CRC32C checksum of every page it writes, and verify it on every read, false
+ * otherwise. Checksums are kept next to the database file, in a file with the extension .crc, which is synced before
+ * the pages are written so that torn writes are caught. A batch of pages takes one sync, shared by writers running at
+ * the same time. Pages written while this is false keep their old checksum, so don't turn it off for a database that
+ * has checksums.
+ */
+extern std::atomic<bool> enable_page_checksums;
+
+/**
+ * True if a DiskManager should store pages compressed, false otherwise. Compressed page images are placed anywhere in
+ * the database file, and a map from page id to image is kept next to it, in a file with the extension .ext. A
+ * database file must always be opened with the same setting.
+ */
+extern std::atomic<bool> enable_page_compression;
+
+/**
+ * True if B+ tree lookups should descend with optimistic lock coupling, false otherwise. Pages are then read without
+ * taking their latch, and the read is validated against the page version afterwards, restarting from the root if a
+ * writer got in the way.
+ */
+extern std::atomic<bool> enable_optimistic_lock_coupling;
+
+/**
+ * True if indexes created from now on should keep their keys normalized where the key schema allows, so that keys
+ * compare with memcmp instead of column by column, false otherwise. NULL keys then order before any other, and equal
+ * each other.
+ */
+extern std::atomic<bool> enable_normalized_keys;
+
+/** True if every buffer pool instance should periodically log its statistics, false otherwise. */
+extern std::atomic<bool> enable_buffer_pool_stats_logging;
+
+/** If ENABLE_BUFFER_POOL_STATS_LOGGING is true, the statistics are logged every BUFFER_POOL_STATS_INTERVAL. */
+extern std::chrono::milliseconds buffer_pool_stats_interval;
+
 static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                      // the header page id
-static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte
-static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
+static constexpr int PAGE_SIZE = BUSTUB_PAGE_SIZE;                            // size of a data page in byte
+static constexpr int BUFFER_POOL_SIZE = 10;                                   // default size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int READAHEAD_MIN_PAGES = 4;                                 // first read-ahead window of a scan
+static constexpr int READAHEAD_MAX_PAGES = 32;                                // largest read-ahead window of a scan
+static constexpr int TABLE_CHAIN_CACHE_PAGES = 4096;                          // page chain links a table heap keeps
+static constexpr int SCAN_RING_SIZE = 32;                                     // frames a bulk scan cycles through
+static constexpr int CACHE_LINE_SIZE = 64;                                    // size of a CPU cache line in byte
+static constexpr double BULK_LOAD_FILL_FACTOR = 0.9;                          // fill factor of bulk loaded B+ trees
+
+static_assert(PAGE_SIZE >= 4096 && PAGE_SIZE <= 32768 && (PAGE_SIZE & (PAGE_SIZE - 1)) == 0,
+              "PAGE_SIZE must be 4096, 8192, 16384 or 32768");
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
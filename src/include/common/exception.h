@@ -47,6 +47,10 @@ enum class ExceptionType {
   OUT_OF_MEMORY = 9,
   /** Method not implemented. */
   NOT_IMPLEMENTED = 11,
+  /** Database file incompatible with this build. */
+  INCOMPATIBLE_FILE = 12,
+  /** Data read from disk is corrupted. */
+  DATA_CORRUPTION = 13,
 };
 
 class Exception : public std::runtime_error {
@@ -98,6 +102,10 @@ class Exception : public std::runtime_error {
         return "Out of Memory";
       case ExceptionType::NOT_IMPLEMENTED:
         return "Not implemented";
+      case ExceptionType::INCOMPATIBLE_FILE:
+        return "Incompatible file";
+      case ExceptionType::DATA_CORRUPTION:
+        return "Data corruption";
       default:
         return "Unknown";
     }
@@ -0,0 +1,38 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// checksum_util.h
+//
+// Identification: src/include/common/util/checksum_util.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * ChecksumUtil computes checksums of page data.
+ */
+class ChecksumUtil {
+ public:
+  /**
+   * Compute the CRC32C (Castagnoli) checksum of a buffer. Uses the SSE4.2 crc32 instruction when the CPU has it, and
+   * a table driven implementation otherwise; both give the same result.
+   * @param data the buffer
+   * @param length the length of the buffer in bytes
+   * @return the checksum
+   */
+  static auto Crc32c(const char *data, size_t length) -> uint32_t;
+
+  /** @return true if Crc32c uses the SSE4.2 crc32 instruction */
+  static auto HasHardwareCrc32c() -> bool;
+};
+
+}  // namespace bustub
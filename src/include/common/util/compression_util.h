@@ -0,0 +1,47 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compression_util.h
+//
+// Identification: src/include/common/util/compression_util.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * CompressionUtil compresses page images. Pages are mostly empty space that was zeroed when the page was created, e.g.
+ * the gap between the slot array and the tuples of a table page, so the format only encodes runs of zero bytes:
+ * a sequence of (literal length, literal bytes, zero run length) tokens, with both lengths stored in 2 bytes.
+ */
+class CompressionUtil {
+ public:
+  /**
+   * Compress a buffer.
+   * @param src the buffer to compress
+   * @param length the length of src in bytes
+   * @param[out] dst the compressed image
+   * @param capacity the size of dst in bytes
+   * @return the length of the compressed image, 0 if it does not fit in capacity bytes
+   */
+  static auto CompressZeroRuns(const char *src, size_t length, char *dst, size_t capacity) -> size_t;
+
+  /**
+   * Decompress an image made by CompressZeroRuns.
+   * @param src the compressed image
+   * @param src_length the length of the compressed image
+   * @param[out] dst the decompressed buffer
+   * @param length the length the decompressed buffer must have
+   * @return false if the image is malformed or does not decompress to exactly length bytes
+   */
+  static auto DecompressZeroRuns(const char *src, size_t src_length, char *dst, size_t length) -> bool;
+};
+
+}  // namespace bustub
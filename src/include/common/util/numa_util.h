@@ -0,0 +1,43 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// numa_util.h
+//
+// Identification: src/include/common/util/numa_util.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace bustub {
+
+/**
+ * NumaUtil places memory on NUMA nodes and finds out where the calling thread runs. It talks to the kernel directly,
+ * so no NUMA library is needed; on systems without NUMA support everything behaves as if there was a single node.
+ */
+class NumaUtil {
+ public:
+  /** @return the ids of the online NUMA nodes in ascending order, {0} if they can't be determined */
+  static auto GetOnlineNodes() -> const std::vector<int> &;
+
+  /** @return the NUMA node the calling thread is currently running on, 0 if it can't be determined */
+  static auto GetCurrentNode() -> int;
+
+  /**
+   * Bind a memory range to a NUMA node, so that its pages are allocated there when they are first touched. Must be
+   * called before the memory is touched.
+   * @param addr page aligned start of the range
+   * @param len length of the range in bytes
+   * @param node the NUMA node to bind the memory to
+   * @return true if the memory was bound, false otherwise
+   */
+  static auto BindToNode(void *addr, size_t len, int node) -> bool;
+};
+
+}  // namespace bustub
@@ -124,17 +124,19 @@ class ExtendibleHashTable {
   /**
    * Fetches the directory page from the buffer pool manager.
    *
+   * @param[out] guard set to the guard that keeps the directory page pinned
    * @return a pointer to the directory page
    */
-  auto FetchDirectoryPage() -> HashTableDirectoryPage *;
+  auto FetchDirectoryPage(BasicPageGuard *guard) -> HashTableDirectoryPage *;
 
   /**
    * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
    *
    * @param bucket_page_id the page_id to fetch
+   * @param[out] guard set to the guard that keeps the bucket page pinned
    * @return a pointer to a bucket page
    */
-  auto FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE *;
+  auto FetchBucketPage(page_id_t bucket_page_id, BasicPageGuard *guard) -> HASH_TABLE_BUCKET_TYPE *;
 
   /**
    * Performs insertion with an optional bucket splitting.
@@ -15,13 +15,31 @@
 #include <atomic>
 #include <fstream>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <map>
+#include <mutex>  // NOLINT
+#include <set>
+#include <shared_mutex>
 #include <string>
+#include <vector>
 
 #include "common/config.h"
 
 namespace bustub {
 
+/** How the DiskManager performs page I/O on the database file. */
+enum class DiskIOBackend {
+  /** A single std::fstream guarded by a latch, so the database does one page I/O at a time. */
+  FSTREAM,
+  /** Positional pread/pwrite on a raw file descriptor, so page I/Os from different threads are in flight at once. */
+  POSIX,
+  /**
+   * Like POSIX, but the file is opened with O_DIRECT so pages are cached only by the buffer pool, not by the OS.
+   * Page buffers should be PAGE_SIZE aligned (buffer pool frames are); other buffers are copied through an aligned
+   * bounce buffer. Falls back to POSIX if the file system does not support direct I/O.
+   */
+  POSIX_DIRECT,
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
@@ -31,13 +49,15 @@ class DiskManager {
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param backend how page I/O on the database file is performed
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, DiskIOBackend backend = DiskIOBackend::FSTREAM);
 
-  ~DiskManager() = default;
+  ~DiskManager();
 
   /**
-   * Shut down the disk manager and close all the file resources.
+   * Shut down the disk manager and close all the file resources. Page I/O in flight on other threads is waited for;
+   * page I/O started afterwards fails.
    */
   void ShutDown();
 
@@ -48,13 +68,62 @@ class DiskManager {
    */
   void WritePage(page_id_t page_id, const char *page_data);
 
+  /**
+   * Write several pages to the database file. With the POSIX backends, runs of consecutive page ids are written
+   * with a single vectored write. The checksums of the whole batch take a single sync. With checksums, the pages are
+   * copied first, so that a page changing during the write still matches its checksum on disk.
+   * @param page_ids ids of the pages
+   * @param page_data raw page data, one buffer per page id
+   * @return false if some page could not be written
+   */
+  auto WritePages(const std::vector<page_id_t> &page_ids, const std::vector<const char *> &page_data) -> bool;
+
+  /** Make every page written so far durable, along with the checksums, extents and free-space map. */
+  void Sync();
+
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @throws Exception if the page does not match its checksum, e.g. after a torn write
    */
   void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Read several pages from the database file. With the POSIX backends, runs of consecutive page ids are read
+   * with a single vectored read.
+   * @param page_ids ids of the pages
+   * @param[out] page_data output buffers, one per page id
+   * @throws Exception if a page does not match its checksum; the other pages are read all the same
+   */
+  void ReadPages(const std::vector<page_id_t> &page_ids, const std::vector<char *> &page_data);
+
+  /**
+   * Record in the free-space map that a page is no longer used, so that ReuseFreePage can hand out its id again.
+   * @param page_id id of the page
+   */
+  void DeallocatePage(page_id_t page_id);
+
+  /**
+   * Take the lowest free page id that is congruent to offset modulo stride out of the free-space map. Buffer pool
+   * instances pass their count and index, so that they only reuse ids they own.
+   * @param stride the modulus page ids are compared under
+   * @param offset the residue the page id must have
+   * @return the page id, INVALID_PAGE_ID if there is no such free page
+   */
+  auto ReuseFreePage(uint32_t stride, uint32_t offset) -> page_id_t;
+
+  /** @return the number of pages in the database file, including free pages and pages that were never written */
+  auto GetNumPages() -> page_id_t;
+
+  /**
+   * Cut free pages off the end of the database file. Free pages elsewhere in the file stay where they are. Must only
+   * be called while no buffer pool uses the disk manager, since it may cut pages the buffer pool still holds.
+   * @return the number of pages that were cut
+   * @throws Exception if a file can't be truncated
+   */
+  auto TruncateFreePages() -> page_id_t;
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -77,9 +146,18 @@ class DiskManager {
   /** @return true iff the in-memory content has not been flushed yet */
   auto GetFlushState() const -> bool;
 
+  /** @return true once ShutDown has been called; pages must not be read or written after that */
+  inline auto IsShutDown() const -> bool { return shut_down_; }
+
   /** @return the number of disk writes */
   auto GetNumWrites() const -> int;
 
+  /** @return the number of pages read that did not match their checksum */
+  auto GetNumChecksumFailures() const -> int;
+
+  /** @return the page I/O backend of this disk manager */
+  inline auto GetBackend() const -> DiskIOBackend { return backend_; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -91,17 +169,158 @@ class DiskManager {
 
  private:
   auto GetFileSize(const std::string &file_name) -> int;
+
+  /** Close the descriptors of the database file and its companion files, once no I/O is using them. */
+  void CloseFiles();
+
+  /**
+   * Take fd_latch_ shared for an I/O on the descriptors. Once the disk manager is shut down, waits until the
+   * descriptors are closed, so that the I/O sees them as closed.
+   * @return the held latch
+   */
+  auto LockFiles() -> std::shared_lock<std::shared_mutex>;
+
+  /**
+   * Write a page and its checksum to the database file. Like WritePages, a copy of the page is written when it has a
+   * checksum. Caller must hold fd_latch_.
+   * @return false if the page could not be written
+   */
+  auto WriteSinglePage(page_id_t page_id, const char *page_data) -> bool;
+
+  /**
+   * Write a page to the database file, after its checksum was stored. Caller must hold fd_latch_.
+   * @return false if the page could not be written
+   */
+  auto WritePageData(page_id_t page_id, const char *page_data) -> bool;
+
+  /** Read a page from the database file without verifying its checksum. */
+  void ReadPageUnchecked(page_id_t page_id, char *page_data);
+
+  /**
+   * Read several pages from the database file with the POSIX backends, without verifying their checksums.
+   * @param order the positions of page_ids, sorted by page id
+   */
+  void ReadPagesUnchecked(const std::vector<page_id_t> &page_ids, const std::vector<char *> &page_data,
+                          const std::vector<size_t> &order);
+
+  /**
+   * Compress a page and write it to its extent. If the extent is too small, the page moves to a free extent, or to the
+   * end of the file; its image is then synced before the extent pointing at it is written, and the old extent is only
+   * reused once the new one is synced. A page that fits is rewritten in place without a sync.
+   * @return false if the page could not be written
+   */
+  auto WriteCompressedPage(page_id_t page_id, const char *page_data) -> bool;
+
+  /** Read a page from its extent and decompress it. Pages that were never written read as zeros. */
+  void ReadCompressedPage(page_id_t page_id, char *page_data);
+
+  /**
+   * The stored checksums of a page. Both the image written last and the one before it are accepted, because a page
+   * write that never happened leaves the old image on disk. A torn write matches neither. This is also the format of
+   * the checksum file.
+   */
+  struct PageChecksum {
+    /** CRC32C of the image written last, and of the image before it. */
+    uint32_t crc_[2];
+    /** Bit i is set if crc_[i] holds a checksum, so that a CRC of 0 is a checksum like any other. */
+    uint32_t present_;
+  };
+  static_assert(sizeof(PageChecksum) == 12);
+
+  /**
+   * Store the checksums of pages that are about to be written, and make them durable before the pages are. The whole
+   * batch takes a single sync of the checksum file, which writers running at the same time share. Pages without
+   * checksums yet have their current image read, so that it stays accepted if the write does not happen. Caller must
+   * hold fd_latch_.
+   * @param page_ids ids of the pages, runs of consecutive ids are stored with one write
+   * @param page_data the new image of every page
+   * @return false if the checksums could not be made durable, in which case the pages must not be written
+   */
+  auto WriteChecksums(const std::vector<page_id_t> &page_ids, const std::vector<const char *> &page_data) -> bool;
+
+  /**
+   * Read the stored checksums of count consecutive pages. Pages that were never written with a checksum have none
+   * present.
+   * @param page_id id of the first page
+   * @param count number of pages
+   * @param[out] checksums output buffer, one entry per page
+   */
+  void ReadChecksums(page_id_t page_id, size_t count, PageChecksum *checksums);
+
+  /**
+   * Verify a page that was just read against its stored checksums. Pages without a checksum are not verified.
+   * @throws Exception if the page matches none of them
+   */
+  void VerifyChecksum(page_id_t page_id, const char *page_data, const PageChecksum &checksum);
+
+  /**
+   * Write the byte of the free-space map that holds the bit of a page, creating the map if there is none yet. Must be
+   * called under free_map_latch_.
+   */
+  void WriteFreeMapByte(page_id_t page_id);
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
+  // stream to write db file, only used by the FSTREAM backend
   std::fstream db_io_;
+  // descriptor of the db file, only used by the POSIX and POSIX_DIRECT backends
+  std::atomic<int> db_fd_{-1};
+  // descriptor of the checksum file holding a PageChecksum per page, -1 if enable_page_checksums was false at
+  // construction
+  std::atomic<int> checksum_fd_{-1};
+  std::string checksum_name_;
+  // in-memory copy of the checksum file, indexed by page id
+  std::vector<PageChecksum> checksums_;
+  std::mutex checksum_latch_;
+  // number of WriteChecksums calls that wrote the checksum file, protected by checksum_latch_
+  uint64_t checksum_writes_{0};
+  // checksum_writes_ as of the last sync of the checksum file, protected by checksum_sync_latch_
+  uint64_t checksum_writes_synced_{0};
+  std::mutex checksum_sync_latch_;
+  std::atomic<int> num_checksum_failures_{0};
+
+  /** Where the compressed image of a page lives in the database file. This is also the format of the extent file. */
+  struct Extent {
+    uint64_t offset_;
+    /** Bytes reserved for the page at offset_, 0 if the page was never written. */
+    uint32_t capacity_;
+    /** Length of the image, PAGE_SIZE if the page is stored uncompressed. */
+    uint32_t length_;
+  };
+  static_assert(sizeof(Extent) == 16);
+  // true if pages are stored compressed, see enable_page_compression
+  bool compressed_{false};
+  // descriptor of the extent file, -1 if pages are not stored compressed
+  std::atomic<int> extent_fd_{-1};
+  std::string extent_name_;
+  // in-memory copy of the extent file, indexed by page id
+  std::vector<Extent> extents_;
+  // end of the last extent, where extents that outgrow their capacity move to if no free extent is large enough
+  uint64_t extents_end_{0};
+  // space before extents_end_ no page uses, as offsets by capacity; extents that pages moved out of go here
+  std::multimap<uint64_t, uint64_t> free_extents_;
+  std::mutex extent_latch_;
+  // descriptor of the free-space map, a bitmap with the bit of every deallocated page set; -1 until a page is freed
+  std::atomic<int> free_map_fd_{-1};
+  std::string free_map_name_;
+  // the pages whose bit is set in the free-space map
+  std::set<page_id_t> free_pages_;
+  // free_pages_ split by page id % free_page_stride_, built by the first ReuseFreePage
+  uint32_t free_page_stride_{0};
+  std::vector<std::set<page_id_t>> free_pages_by_offset_;
+  std::mutex free_map_latch_;
+  // held shared by every I/O on the descriptors above, and exclusively while they are closed
+  std::shared_mutex fd_latch_;
+  // held while the descriptors are closed, so that I/O issued after ShutDown waits for it instead of starving it
+  std::mutex close_latch_;
   std::string file_name_;
+  DiskIOBackend backend_;
+  std::atomic<bool> shut_down_{false};
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
-  // With multiple buffer pool instances, need to protect file access
+  // With multiple buffer pool instances, need to protect file access (FSTREAM backend only)
   std::mutex db_io_latch_;
 };
 
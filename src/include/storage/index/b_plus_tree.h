@@ -10,8 +10,11 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "concurrency/transaction.h"
@@ -48,6 +51,9 @@ class BPlusTree {
   // Insert a key-value pair into this B+ tree.
   auto Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr) -> bool;
 
+  // Build this empty B+ tree bottom-up from key-value pairs, sorting them first unless they already are.
+  auto BulkLoad(std::vector<std::pair<KeyType, ValueType>> *entries, double fill_factor = BULK_LOAD_FILL_FACTOR) -> bool;
+
   // Remove a key and its value from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
@@ -55,8 +61,9 @@ class BPlusTree {
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr) -> bool;
 
   // index iterator
-  auto Begin() -> INDEXITERATOR_TYPE;
-  auto Begin(const KeyType &key) -> INDEXITERATOR_TYPE;
+  // a bulk scan passes a buffer access strategy to read the leaf pages through a ring of frames
+  auto Begin(BufferAccessStrategy *strategy = nullptr) -> INDEXITERATOR_TYPE;
+  auto Begin(const KeyType &key, BufferAccessStrategy *strategy = nullptr) -> INDEXITERATOR_TYPE;
   auto End() -> INDEXITERATOR_TYPE;
   auto begin() -> INDEXITERATOR_TYPE { return Begin(); }
   auto end() -> INDEXITERATOR_TYPE { return End(); }
@@ -73,27 +80,34 @@ class BPlusTree {
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
   // expose for test purpose
-  auto FindLeafPage(const KeyType &key, int option = 0) -> Page *;
+  // the leaf page is returned read-latched, or an empty guard if the tree is empty
+  auto FindLeafPage(const KeyType &key, int option = 0) -> ReadPageGuard;
 
  private:
   void StartNewTree(const KeyType &key, const ValueType &value);
   void StartNewRoot(BPlusTreePage *left_node, const KeyType &key, BPlusTreePage *right_node);
 
-  auto InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr) -> bool;
+  auto InsertIntoLeaf(const KeyType &key, const ValueType &value, WritePageGuard root_guard,
+                      Transaction *transaction = nullptr) -> bool;
+
+  auto FindLeafPageForWrite(const KeyType &key) -> WritePageGuard;
+  auto FindLeafPageOptimistic(const KeyType &key, uint64_t *version) -> BasicPageGuard;
+  auto LatchRootForWrite() -> WritePageGuard;
 
   void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
                         Transaction *transaction = nullptr);
 
   template <typename N>
   auto Split(N *node) -> N *;
-  auto SplitLeafNode(LeafPage *left_node) -> LeafPage *;
-  auto SplitInternalNode(InternalPage *left_node) -> InternalPage *;
+  // the new right page is returned pinned, and is unpinned dirty when the guard is dropped
+  auto SplitLeafNode(LeafPage *left_node) -> BasicPageGuard;
+  auto SplitInternalNode(InternalPage *left_node) -> BasicPageGuard;
 
   template <typename N>
   auto CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr) -> bool;
 
-  void AdjustLeafNode(LeafPage *leaf_node, const KeyType &key, Transaction *transaction);
-  void AdjustInternalNode(InternalPage *internal_node, const KeyType &key, Transaction *transaction);
+  void AdjustLeafNode(LeafPage *leaf_node, const KeyType &key, std::vector<page_id_t> *deleted_pages);
+  void AdjustInternalNode(InternalPage *internal_node, const KeyType &key, std::vector<page_id_t> *deleted_pages);
 
   template <typename N>
   auto Coalesce(N **neighbor_node, N **node, BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent,
@@ -113,12 +127,14 @@ class BPlusTree {
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  // read without any latch; only changed while the old root is write-latched, or under root_latch_ if it was empty
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
-  ReaderWriterLatch rwlatch_;
+  // serializes the creation of the root of an empty tree
+  std::mutex root_latch_;
 };
 
 }  // namespace bustub
@@ -14,6 +14,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "storage/index/b_plus_tree.h"
@@ -30,13 +31,20 @@ class BPlusTreeIndex : public Index {
 
   void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
+  /**
+   * Insert many entries at once. An empty index is built bottom-up; otherwise the entries are inserted one at a time.
+   * @param entries The index keys and their RIDs, which may be reordered
+   * @param transaction The transaction context
+   */
+  void BulkLoad(std::vector<std::pair<Tuple, RID>> *entries, Transaction *transaction);
+
   void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
-  auto GetBeginIterator() -> INDEXITERATOR_TYPE;
+  auto GetBeginIterator(BufferAccessStrategy *strategy = nullptr) -> INDEXITERATOR_TYPE;
 
-  auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
+  auto GetBeginIterator(const KeyType &key, BufferAccessStrategy *strategy = nullptr) -> INDEXITERATOR_TYPE;
 
   auto GetEndIterator() -> INDEXITERATOR_TYPE;
 
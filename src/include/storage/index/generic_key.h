@@ -13,18 +13,35 @@
 #pragma once
 
 #include <cstring>
+#include <type_traits>
+#include <vector>
 
+#include "common/exception.h"
+#include "common/macros.h"
 #include "storage/table/tuple.h"
+#include "type/limits.h"
 #include "type/value.h"
 
 namespace bustub {
 
+template <size_t KeySize>
+class GenericComparator;
+
 /**
  * Generic key is used for indexing with opaque data.
  *
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
  * with a template argument.
+ *
+ * The data is either the raw key tuple, or its normalized form, in which
+ * memcmp orders keys like SQL does, with NULL before any other value:
+ * - integers and booleans are stored big-endian with their sign bit flipped
+ * - timestamps are stored big-endian, plus one so that NULL wraps around to 0
+ * - decimals are stored big-endian with their sign bit flipped if positive,
+ *   and all their bits flipped if negative; NULL is stored as 0
+ * - varchars are stored as a NULL flag, the characters padded with zeros to
+ *   the declared length of the column, and the length big-endian
  */
 template <size_t KeySize>
 class GenericKey {
@@ -35,6 +52,108 @@ class GenericKey {
     memcpy(data_, tuple.GetData(), tuple.GetLength());
   }
 
+  // set the key in the format the comparator compares keys in
+  inline void SetFromKey(const Tuple &tuple, const GenericComparator<KeySize> &comparator) {
+    if (comparator.IsNormalized()) {
+      SetFromKeyNormalized(tuple, comparator.GetKeySchema());
+    } else {
+      SetFromKey(tuple);
+    }
+  }
+
+  inline void SetFromKeyNormalized(const Tuple &tuple, Schema *key_schema) {
+    memset(data_, 0, KeySize);
+    auto *out = reinterpret_cast<uint8_t *>(data_);
+    for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+      const auto &col = key_schema->GetColumn(i);
+      const char *data_ptr = tuple.GetData() + col.GetOffset();
+      switch (col.GetType()) {
+        case TypeId::BOOLEAN:
+        case TypeId::TINYINT:
+          out = EncodeInteger<int8_t>(out, data_ptr);
+          break;
+        case TypeId::SMALLINT:
+          out = EncodeInteger<int16_t>(out, data_ptr);
+          break;
+        case TypeId::INTEGER:
+          out = EncodeInteger<int32_t>(out, data_ptr);
+          break;
+        case TypeId::BIGINT:
+          out = EncodeInteger<int64_t>(out, data_ptr);
+          break;
+        case TypeId::TIMESTAMP: {
+          uint64_t value;
+          memcpy(&value, data_ptr, sizeof(uint64_t));
+          out = EncodeBigEndian(out, value + 1, sizeof(uint64_t));
+          break;
+        }
+        case TypeId::DECIMAL: {
+          double value;
+          memcpy(&value, data_ptr, sizeof(double));
+          uint64_t bits = 0;
+          if (value != BUSTUB_DECIMAL_NULL) {
+            // -0.0 equals 0.0, so it has to be stored the same
+            value = value == 0 ? 0 : value;
+            memcpy(&bits, &value, sizeof(double));
+            bits = (bits >> 63) != 0 ? ~bits : bits | (uint64_t{1} << 63);
+          }
+          out = EncodeBigEndian(out, bits, sizeof(uint64_t));
+          break;
+        }
+        case TypeId::VARCHAR: {
+          Value value = tuple.GetValue(key_schema, i);
+          if (!value.IsNull()) {
+            // the length of a varchar value counts its terminating null character
+            uint32_t length = value.GetLength() == 0 ? 0 : value.GetLength() - 1;
+            if (length > col.GetLength()) {
+              throw Exception(ExceptionType::OUT_OF_RANGE, "varchar is longer than its column in a normalized key");
+            }
+            out[0] = 1;
+            memcpy(out + 1, value.GetData(), length);
+            EncodeBigEndian(out + 1 + col.GetLength(), length, sizeof(uint16_t));
+          }
+          out += 1 + col.GetLength() + sizeof(uint16_t);
+          break;
+        }
+        default:
+          throw Exception(ExceptionType::MISMATCH_TYPE, "key type can't be normalized");
+      }
+    }
+  }
+
+  // @return the size of the normalized form of keys of key_schema, 0 if a column of it can't be normalized
+  static inline auto NormalizedSize(const Schema *key_schema) -> size_t {
+    size_t size = 0;
+    for (const auto &col : key_schema->GetColumns()) {
+      switch (col.GetType()) {
+        case TypeId::BOOLEAN:
+        case TypeId::TINYINT:
+        case TypeId::SMALLINT:
+        case TypeId::INTEGER:
+        case TypeId::BIGINT:
+        case TypeId::TIMESTAMP:
+        case TypeId::DECIMAL:
+          size += col.GetFixedLength();
+          break;
+        case TypeId::VARCHAR:
+          if (col.GetLength() > UINT16_MAX) {
+            return 0;
+          }
+          size += 1 + col.GetLength() + sizeof(uint16_t);
+          break;
+        default:
+          return 0;
+      }
+    }
+    return size;
+  }
+
+  // @return true if keys of key_schema fit into KeySize bytes normalized
+  static inline auto CanNormalize(const Schema *key_schema) -> bool {
+    size_t size = NormalizedSize(key_schema);
+    return size > 0 && size <= KeySize;
+  }
+
   // NOTE: for test purpose only
   inline void SetFromInteger(int64_t key) {
     memset(data_, 0, KeySize);
@@ -68,6 +187,24 @@ class GenericKey {
 
   // actual location of data, extends past the end.
   char data_[KeySize];
+
+ private:
+  static inline auto EncodeBigEndian(uint8_t *out, uint64_t value, size_t size) -> uint8_t * {
+    for (size_t i = 0; i < size; i++) {
+      out[i] = static_cast<uint8_t>(value >> ((size - 1 - i) * 8));
+    }
+    return out + size;
+  }
+
+  template <class T>
+  static inline auto EncodeInteger(uint8_t *out, const char *data_ptr) -> uint8_t * {
+    T value;
+    memcpy(&value, data_ptr, sizeof(T));
+    // Flipping the sign bit puts negative values before positive ones, and NULL, the smallest value, first.
+    auto bits = static_cast<uint64_t>(static_cast<std::make_unsigned_t<T>>(value));
+    bits ^= uint64_t{1} << (sizeof(T) * 8 - 1);
+    return EncodeBigEndian(out, bits, sizeof(T));
+  }
 };
 
 /**
@@ -77,6 +214,14 @@ template <size_t KeySize>
 class GenericComparator {
  public:
   inline auto operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const -> int {
+    if (normalized_size_ > 0) {
+      int result = memcmp(lhs.data_, rhs.data_, normalized_size_);
+      return result < 0 ? -1 : (result > 0 ? 1 : 0);
+    }
+    if (!integer_columns_.empty()) {
+      return CompareIntegerColumns(lhs, rhs);
+    }
+
     uint32_t column_count = key_schema_->GetColumnCount();
 
     for (uint32_t i = 0; i < column_count; i++) {
@@ -94,13 +239,92 @@ class GenericComparator {
     return 0;
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  GenericComparator(const GenericComparator &other) = default;
+
+  /**
+   * @param key_schema the schema of the keys
+   * @param normalized true if the keys are normalized, which requires GenericKey::CanNormalize(key_schema)
+   */
+  explicit GenericComparator(Schema *key_schema, bool normalized = false) : key_schema_(key_schema) {
+    if (normalized) {
+      BUSTUB_ASSERT(GenericKey<KeySize>::CanNormalize(key_schema), "Keys of this schema can't be normalized.");
+      normalized_size_ = GenericKey<KeySize>::NormalizedSize(key_schema);
+      return;
+    }
+
+    // Keys made of integer columns only, the most common ones, are compared in place instead of through a Value per
+    // column, which saves deserializing both keys and several virtual calls on every step of a search.
+    for (const auto &col : key_schema_->GetColumns()) {
+      switch (col.GetType()) {
+        case TypeId::TINYINT:
+        case TypeId::SMALLINT:
+        case TypeId::INTEGER:
+        case TypeId::BIGINT:
+          integer_columns_.push_back({col.GetOffset(), col.GetType()});
+          break;
+        default:
+          integer_columns_.clear();
+          return;
+      }
+    }
+  }
+
+  // @return true if the keys compared are normalized, false if they are raw key tuples
+  inline auto IsNormalized() const -> bool { return normalized_size_ > 0; }
 
-  // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  inline auto GetKeySchema() const -> Schema * { return key_schema_; }
 
  private:
+  struct IntegerColumn {
+    uint32_t offset_;
+    TypeId type_;
+  };
+
+  inline auto CompareIntegerColumns(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const -> int {
+    for (const auto &column : integer_columns_) {
+      const char *lhs_data = lhs.data_ + column.offset_;
+      const char *rhs_data = rhs.data_ + column.offset_;
+      int result = 0;
+      switch (column.type_) {
+        case TypeId::TINYINT:
+          result = CompareInteger<int8_t>(lhs_data, rhs_data, BUSTUB_INT8_NULL);
+          break;
+        case TypeId::SMALLINT:
+          result = CompareInteger<int16_t>(lhs_data, rhs_data, BUSTUB_INT16_NULL);
+          break;
+        case TypeId::INTEGER:
+          result = CompareInteger<int32_t>(lhs_data, rhs_data, BUSTUB_INT32_NULL);
+          break;
+        default:
+          result = CompareInteger<int64_t>(lhs_data, rhs_data, BUSTUB_INT64_NULL);
+          break;
+      }
+      if (result != 0) {
+        return result;
+      }
+    }
+    // equals
+    return 0;
+  }
+
+  template <class T>
+  static inline auto CompareInteger(const char *lhs_data, const char *rhs_data, T null_value) -> int {
+    T lhs_value;
+    T rhs_value;
+    memcpy(&lhs_value, lhs_data, sizeof(T));
+    memcpy(&rhs_value, rhs_data, sizeof(T));
+    // Like a Value, NULL is neither less nor greater than anything, so the next column decides.
+    if (lhs_value == null_value || rhs_value == null_value) {
+      return 0;
+    }
+    return lhs_value < rhs_value ? -1 : (lhs_value > rhs_value ? 1 : 0);
+  }
+
   Schema *key_schema_;
+  // the columns of the key if they are all integers, empty otherwise
+  std::vector<IntegerColumn> integer_columns_;
+  // the size of the keys if they are normalized and compared with memcmp, 0 otherwise
+  size_t normalized_size_{0};
 };
 
 }  // namespace bustub
@@ -14,6 +14,7 @@
  */
 #pragma once
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -25,8 +26,10 @@ class IndexIterator {
 
  public:
   // you may define your own constructor based on your member variables
-  IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index);
-  ~IndexIterator();  // NOLINT
+  // the iterator keeps the leaf page it is positioned on pinned and read-latched through its guard, which is empty
+  // for an empty tree
+  IndexIterator(BufferPoolManager *buffer_pool_manager, ReadPageGuard guard, int index,
+                BufferAccessStrategy *strategy = nullptr);
 
   auto IsEnd() -> bool;
   auto isEnd() -> bool { return IsEnd(); }
@@ -37,6 +40,10 @@ class IndexIterator {
 
   auto operator==(const IndexIterator &itr) const -> bool {
     // throw std::runtime_error("unimplemented");
+    // iterators of an empty tree hold no leaf page
+    if (node_ == nullptr || itr.node_ == nullptr) {
+      return node_ == itr.node_;
+    }
     return node_->GetPageId() == itr.node_->GetPageId() && index_ == itr.index_;
   }
 
@@ -48,9 +55,11 @@ class IndexIterator {
  private:
   // add your own private member variables here
   BufferPoolManager *buffer_pool_manager_;
-  Page *page_;
+  ReadPageGuard guard_;
   int index_;
-  LeafPage *node_;
+  const LeafPage *node_;
+  /** The buffer access strategy leaf pages are fetched through, nullptr for a normal scan. */
+  BufferAccessStrategy *strategy_;
 };
 
 }  // namespace bustub
@@ -19,16 +19,21 @@ namespace bustub {
 /**
  * Database use the first page (page_id = 0) as header page to store metadata, in
  * our case, we will contain information about table/index name (length less than
- * 32 bytes) and their corresponding root_id
+ * 32 bytes) and their corresponding root_id. Bytes 4092-4095 hold the page size the
+ * database file was created with, 0 if it was never recorded. They are at the same
+ * place for every page size, so that any build can tell which one a file uses.
  *
  * Format (size in byte):
- *  -----------------------------------------------------------------
- * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
- *  -----------------------------------------------------------------
+ *  ------------------------------------------------------------------------------------
+ * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... | PageSize (4) |
+ *  ------------------------------------------------------------------------------------
  */
 class HeaderPage : public Page {
  public:
-  void Init() { SetRecordCount(0); }
+  void Init() {
+    SetRecordCount(0);
+    SetPageSize(PAGE_SIZE);
+  }
   /**
    * Record related
    */
@@ -40,6 +45,16 @@ class HeaderPage : public Page {
   auto GetRootId(const std::string &name, page_id_t *root_id) -> bool;
   auto GetRecordCount() -> int;
 
+  /** @return the page size recorded in the header page, 0 if none was recorded */
+  auto GetPageSize() -> int;
+
+  /**
+   * Make sure the database file was created with the page size of this build. Header pages that were written before
+   * page sizes were recorded are taken to use the current page size, which is recorded from then on.
+   * @throws Exception if the database file uses a different page size
+   */
+  void CheckPageSize();
+
  private:
   /**
    * helper functions
@@ -47,5 +62,9 @@ class HeaderPage : public Page {
   auto FindRecord(const std::string &name) -> int;
 
   void SetRecordCount(int record_count);
+
+  void SetPageSize(int page_size);
+
+  static constexpr size_t OFFSET_PAGE_SIZE = 4092;
 };
 }  // namespace bustub
@@ -12,8 +12,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <new>
+#include <thread>  // NOLINT
 
 #include "common/config.h"
 #include "common/rwlatch.h"
@@ -24,17 +27,25 @@ namespace bustub {
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * Pages are cache line aligned, so that the book-keeping of one frame never shares a cache line with its neighbours
+ * and pinning a page doesn't slow down threads working on the frames next to it.
  */
-class Page {
+class alignas(CACHE_LINE_SIZE) Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManagerInstance;
+  friend class MmapBufferPoolManager;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. The page owns zeroed, PAGE_SIZE aligned data, e.g. for a page used outside of a buffer pool. */
+  Page() : data_(new (std::align_val_t(PAGE_SIZE)) char[PAGE_SIZE]()), owns_data_(true) {}
 
-  /** Default destructor. */
-  ~Page() = default;
+  /** Destructor. Frees the data if the page owns it. */
+  ~Page() {
+    if (owns_data_) {
+      ::operator delete[](data_, std::align_val_t(PAGE_SIZE));
+    }
+  }
 
   /** @return the actual data contained within this page */
   inline auto GetData() -> char * { return data_; }
@@ -48,11 +59,49 @@ class Page {
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline auto IsDirty() -> bool { return is_dirty_; }
 
-  /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
-
-  /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  /** Acquire the page write latch. The version of the page turns odd, failing every optimistic read under way. */
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  /** Release the page write latch. The version of the page turns even again, and differs from before the latch. */
+  inline void WUnlatch() {
+    version_.fetch_add(1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
+
+  /**
+   * Start an optimistic read of the page, which takes no latch. Waits while a writer holds the page.
+   * @return the version to validate the read against
+   */
+  inline auto ReadVersion() -> uint64_t {
+    uint64_t version;
+    while (((version = version_.load(std::memory_order_acquire)) & 1) != 0) {
+      std::this_thread::yield();
+    }
+    return version;
+  }
+
+  /**
+   * Finish an optimistic read of the page. What was read is only meaningful if no writer held the page meanwhile.
+   * @param version the version returned by ReadVersion
+   * @return true if no writer held the page since version was read, false otherwise
+   */
+  inline auto ValidateVersion(uint64_t version) -> bool {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
+  /**
+   * Check that the caller's write latch was the only one taken since an optimistic read, i.e. the page is still as it
+   * was read.
+   * @param version the version returned by ReadVersion, before the caller write-latched the page
+   * @return true if no other writer held the page since version was read, false otherwise
+   */
+  inline auto ValidateVersionLatched(uint64_t version) -> bool {
+    return version_.load(std::memory_order_relaxed) == version + 1;
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -75,19 +124,36 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
+  /**
+   * Constructor for buffer pools. The page uses memory the buffer pool owns, e.g. a frame or a mapping of the file.
+   * @param data PAGE_SIZE bytes of memory, which must outlive the page
+   */
+  explicit Page(char *data) : data_(data) {}
+
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  /** The actual data that is stored within a page. Points at a PAGE_SIZE aligned frame for buffer pool pages. */
+  char *data_;
+  /** True if data_ was allocated by the page itself. */
+  bool owns_data_{false};
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
   /** The pin count of this page. */
-  int pin_count_ = 0;
+  std::atomic<int> pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_ = false;
+  /** True while the buffer pool reads the page into its frame. Guarded by the page table partition latch. */
+  bool is_loading_ = false;
+  /** True if the page was last pinned through a buffer access strategy. Guarded by the page table partition latch. */
+  bool is_cold_ = false;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /**
+   * Incremented when the page is write-latched and when it is released, so it is odd while a writer holds it. It has a
+   * cache line of its own, so that optimistic readers pinning the page don't invalidate it for each other.
+   */
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> version_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,215 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard holds the pin of a page and unpins it when it goes out of scope, or when it is dropped earlier.
+ * Guards can be moved but not copied, so that every pin is released exactly once, even when an exception is thrown.
+ * The page is unpinned dirty if it was ever accessed through AsMut, GetDataMut or SetDirty.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /**
+   * Take over the pin of a page.
+   * @param bpm the buffer pool the page was pinned in
+   * @param page the pinned page, nullptr for an empty guard
+   */
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  auto operator=(const BasicPageGuard &) -> BasicPageGuard & = delete;
+
+  /** Take over the pin of another guard, which is left empty. */
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** Release the pin this guard holds, if any, and take over the pin of another guard, which is left empty. */
+  auto operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard &;
+
+  ~BasicPageGuard() { Drop(); }
+
+  /** Unpin the page now. The guard is empty afterwards. */
+  void Drop();
+
+  /** @return true if the guard holds a page, false if it is empty */
+  auto IsValid() const -> bool { return page_ != nullptr; }
+
+  /** @return the id of the guarded page */
+  auto PageId() -> page_id_t { return page_->GetPageId(); }
+
+  /** @return the guarded page */
+  auto GetPage() -> Page * { return page_; }
+
+  /** @return the data of the guarded page */
+  auto GetData() -> const char * { return page_->GetData(); }
+
+  /** @return the data of the guarded page, which is unpinned dirty */
+  auto GetDataMut() -> char * {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  /** Unpin the page dirty. For pages that are modified through GetPage. */
+  void SetDirty() { is_dirty_ = true; }
+
+  /**
+   * Read-latch the page and hand the pin over to a ReadPageGuard. This guard is empty afterwards.
+   * @return a guard holding the pin and the read latch, empty if this guard was empty
+   */
+  auto UpgradeRead() -> ReadPageGuard;
+
+  /**
+   * Write-latch the page and hand the pin over to a WritePageGuard. This guard is empty afterwards.
+   * @return a guard holding the pin and the write latch, empty if this guard was empty
+   */
+  auto UpgradeWrite() -> WritePageGuard;
+
+  /** @return the data of the guarded page as a T */
+  template <class T>
+  auto As() -> const T * {
+    return reinterpret_cast<const T *>(GetData());
+  }
+
+  /** @return the data of the guarded page as a T, which is unpinned dirty */
+  template <class T>
+  auto AsMut() -> T * {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard holds the pin and the read latch of a page, and releases both when it goes out of scope.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /**
+   * Take over the pin and the read latch of a page.
+   * @param bpm the buffer pool the page was pinned in
+   * @param page the pinned and read-latched page, nullptr for an empty guard
+   */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  auto operator=(const ReadPageGuard &) -> ReadPageGuard & = delete;
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+  auto operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard &;
+
+  ~ReadPageGuard() { Drop(); }
+
+  /** Release the read latch and unpin the page now. The guard is empty afterwards. */
+  void Drop();
+
+  /** @return true if the guard holds a page, false if it is empty */
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  /** @return the id of the guarded page */
+  auto PageId() -> page_id_t { return guard_.PageId(); }
+
+  /** @return the guarded page */
+  auto GetPage() -> Page * { return guard_.GetPage(); }
+
+  /** @return the data of the guarded page */
+  auto GetData() -> const char * { return guard_.GetData(); }
+
+  /** @return the data of the guarded page as a T */
+  template <class T>
+  auto As() -> const T * {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard holds the pin and the write latch of a page, and releases both when it goes out of scope.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /**
+   * Take over the pin and the write latch of a page.
+   * @param bpm the buffer pool the page was pinned in
+   * @param page the pinned and write-latched page, nullptr for an empty guard
+   */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  auto operator=(const WritePageGuard &) -> WritePageGuard & = delete;
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+  auto operator=(WritePageGuard &&that) noexcept -> WritePageGuard &;
+
+  ~WritePageGuard() { Drop(); }
+
+  /** Release the write latch and unpin the page now. The guard is empty afterwards. */
+  void Drop();
+
+  /** @return true if the guard holds a page, false if it is empty */
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  /** @return the id of the guarded page */
+  auto PageId() -> page_id_t { return guard_.PageId(); }
+
+  /** @return the guarded page */
+  auto GetPage() -> Page * { return guard_.GetPage(); }
+
+  /** @return the data of the guarded page */
+  auto GetData() -> const char * { return guard_.GetData(); }
+
+  /** @return the data of the guarded page, which is unpinned dirty */
+  auto GetDataMut() -> char * { return guard_.GetDataMut(); }
+
+  /** Unpin the page dirty. For pages that are modified through GetPage. */
+  void SetDirty() { guard_.SetDirty(); }
+
+  /** @return the data of the guarded page as a T */
+  template <class T>
+  auto As() -> const T * {
+    return guard_.As<T>();
+  }
+
+  /** @return the data of the guarded page as a T, which is unpinned dirty */
+  template <class T>
+  auto AsMut() -> T * {
+    return guard_.AsMut<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
@@ -12,6 +12,14 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -28,7 +36,7 @@ class TableHeap {
   friend class TableIterator;
 
  public:
-  ~TableHeap() = default;
+  ~TableHeap();
 
   /**
    * Create a table heap without a transaction. (open table)
@@ -99,8 +107,12 @@ class TableHeap {
    */
   auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) -> bool;
 
-  /** @return the begin iterator of this table */
-  auto Begin(Transaction *txn) -> TableIterator;
+  /**
+   * @param txn the transaction performing the scan
+   * @param strategy the buffer access strategy of a bulk scan, nullptr to read pages normally
+   * @return the begin iterator of this table
+   */
+  auto Begin(Transaction *txn, BufferAccessStrategy *strategy = nullptr) -> TableIterator;
 
   /** @return the end iterator of this table */
   auto End() -> TableIterator;
@@ -108,11 +120,68 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /**
+   * Remember that next_page_id follows page_id in the page chain. Pages are never unlinked from a table heap, so a
+   * recorded link stays valid; only the TABLE_CHAIN_CACHE_PAGES most recently recorded links are kept.
+   * @param page_id the id of a page of this table
+   * @param next_page_id the id of the page that follows it
+   */
+  void RecordNextPageId(page_id_t page_id, page_id_t next_page_id);
+
+  /**
+   * @param page_id the id of a page of this table
+   * @param count the maximum number of page ids to return
+   * @return the ids of up to count pages that follow page_id, as far as the recorded links of the chain go
+   */
+  auto GetNextPageIds(page_id_t page_id, size_t count) -> std::vector<page_id_t>;
+
+  /**
+   * Prefetch pages on the read-ahead thread of this table heap, which is started by the first request.
+   * @param page_ids ids of the pages to prefetch
+   * @param strategy the buffer access strategy to prefetch through, which must outlive the request
+   * @return a ticket to wait for the request with
+   */
+  auto ReadAheadAsync(std::vector<page_id_t> page_ids, BufferAccessStrategy *strategy) -> uint64_t;
+
+  /**
+   * Wait until a read-ahead request, and every request issued before it, is done.
+   * @param ticket the ticket returned by ReadAheadAsync
+   */
+  void WaitForReadAhead(uint64_t ticket);
+
  private:
+  /** Read-ahead thread body. Prefetches the requested pages in order until the table heap is destroyed. */
+  void RunReadAhead();
+
+  /** A read-ahead request waiting for the read-ahead thread. */
+  struct ReadAheadRequest {
+    std::vector<page_id_t> page_ids_;
+    BufferAccessStrategy *strategy_;
+  };
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+
+  /** Protects next_page_ids_ and chain_order_. */
+  std::mutex chain_latch_;
+  /** The recorded links of the page chain, from a page to the page that follows it. */
+  std::unordered_map<page_id_t, page_id_t> next_page_ids_;
+  /** The pages of next_page_ids_ in the order their links were recorded, so that the oldest link is dropped first. */
+  std::deque<page_id_t> chain_order_;
+
+  /** Protects the read-ahead state below. */
+  std::mutex readahead_latch_;
+  /** Signalled when a request is queued, when a request is done, and when the thread should stop. */
+  std::condition_variable readahead_cv_;
+  std::deque<ReadAheadRequest> readahead_requests_;
+  /** Number of requests issued and done so far; a request's ticket is the number of requests issued up to it. */
+  uint64_t readahead_issued_{0};
+  uint64_t readahead_done_{0};
+  bool stop_readahead_{false};
+  /** Read-ahead thread, nullptr until the first request. */
+  std::unique_ptr<std::thread> readahead_thread_;
 };
 
 }  // namespace bustub
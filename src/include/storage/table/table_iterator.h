@@ -13,7 +13,9 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -29,12 +31,18 @@ class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy = nullptr);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
-
-  ~TableIterator() { delete tuple_; }
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_) {}
+
+  ~TableIterator() {
+    ResetReadAhead();
+    delete tuple_;
+  }
 
   inline auto operator==(const TableIterator &itr) const -> bool {
     return tuple_->rid_.Get() == itr.tuple_->rid_.Get();
@@ -51,16 +59,37 @@ class TableIterator {
   auto operator++(int) -> TableIterator;
 
   auto operator=(const TableIterator &other) -> TableIterator & {
+    ResetReadAhead();
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
     return *this;
   }
 
  private:
+  /**
+   * Called whenever the scan follows the page chain into page_id. Requests the pages that follow page_id from the
+   * read-ahead thread of the table heap, doubling the request size on every request up to READAHEAD_MAX_PAGES.
+   * @param page_id the page the scan has just moved to
+   */
+  void ReadAhead(page_id_t page_id);
+
+  /** Wait for the read-ahead request in flight and start over with the smallest window. */
+  void ResetReadAhead();
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** The buffer access strategy pages are fetched through, nullptr for a normal scan. */
+  BufferAccessStrategy *strategy_;
+
+  /** The number of pages the next read-ahead request covers, 0 until the scan crosses a page boundary. */
+  size_t readahead_window_{0};
+  /** The number of pages after the current page that have already been requested. */
+  size_t pages_read_ahead_{0};
+  /** Ticket of the last read-ahead request of this iterator, 0 if it has not made any. */
+  uint64_t readahead_ticket_{0};
 };
 
 }  // namespace bustub
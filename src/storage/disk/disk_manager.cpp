@@ -10,27 +10,97 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <new>
+#include <optional>
+#include <shared_mutex>
 #include <string>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/util/checksum_util.h"
+#include "common/util/compression_util.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 static char *buffer_used;
 
+/** Per-thread aligned staging buffer for O_DIRECT I/O on caller buffers that are not PAGE_SIZE aligned. */
+alignas(PAGE_SIZE) static thread_local char bounce_buffer[PAGE_SIZE];
+
+/** Per-thread copy of a page being written with a checksum, so that the page can't change between the two. */
+alignas(PAGE_SIZE) static thread_local char write_buffer[PAGE_SIZE];
+
+/** Per-thread buffer holding a compressed page image. */
+static thread_local char compression_buffer[PAGE_SIZE];
+
+/** Compressed page images are given space in multiples of this, so that they can grow a little in place. */
+static constexpr size_t EXTENT_ALIGNMENT = 512;
+
+/** @return true if buf can be used for O_DIRECT I/O as is */
+static inline auto IsPageAligned(const char *buf) -> bool { return reinterpret_cast<uintptr_t>(buf) % PAGE_SIZE == 0; }
+
+/**
+ * Write all of buf at offset, retrying on partial writes and interrupts.
+ * @return false on I/O error
+ */
+static auto PositionalWrite(int fd, const char *buf, size_t count, off_t offset) -> bool {
+  while (count > 0) {
+    ssize_t written = pwrite(fd, buf, count, offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    buf += written;
+    count -= written;
+    offset += written;
+  }
+  return true;
+}
+
+/**
+ * Read up to count bytes at offset, retrying on partial reads and interrupts.
+ * @return the number of bytes read, which is less than count only at end of file, or -1 on I/O error
+ */
+static auto PositionalRead(int fd, char *buf, size_t count, off_t offset) -> ssize_t {
+  size_t total = 0;
+  while (total < count) {
+    ssize_t nread = pread(fd, buf + total, count - total, offset + total);
+    if (nread < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    if (nread == 0) {
+      break;
+    }
+    total += nread;
+  }
+  return static_cast<ssize_t>(total);
+}
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, DiskIOBackend backend) : file_name_(db_file), backend_(backend) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -52,6 +122,96 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
     }
   }
 
+  buffer_used = nullptr;
+  bool new_file = GetFileSize(file_name_) <= 0;
+
+  if (enable_page_checksums) {
+    checksum_name_ = file_name_.substr(0, n) + ".crc";
+    // checksums left behind by an earlier database file of the same name must not be applied to a new one
+    checksum_fd_ = open(checksum_name_.c_str(), O_RDWR | O_CREAT | (new_file ? O_TRUNC : 0), 0644);
+    if (checksum_fd_ < 0) {
+      throw Exception("can't open checksum file");
+    }
+    // keep every checksum in memory, so that verifying a page costs no extra I/O
+    checksums_.resize(std::max(GetFileSize(checksum_name_), 0) / sizeof(PageChecksum));
+    if (PositionalRead(checksum_fd_, reinterpret_cast<char *>(checksums_.data()),
+                       checksums_.size() * sizeof(PageChecksum), 0) < 0) {
+      throw Exception("can't read checksum file");
+    }
+  }
+
+  if (enable_page_compression) {
+    // compressed page images have arbitrary lengths and offsets, which only positional I/O can handle
+    compressed_ = true;
+    backend_ = DiskIOBackend::POSIX;
+    extent_name_ = file_name_.substr(0, n) + ".ext";
+    extent_fd_ = open(extent_name_.c_str(), O_RDWR | O_CREAT | (new_file ? O_TRUNC : 0), 0644);
+    if (extent_fd_ < 0) {
+      throw Exception("can't open extent file");
+    }
+    extents_.resize(std::max(GetFileSize(extent_name_), 0) / sizeof(Extent));
+    if (PositionalRead(extent_fd_, reinterpret_cast<char *>(extents_.data()), extents_.size() * sizeof(Extent), 0) <
+        0) {
+      throw Exception("can't read extent file");
+    }
+    // the gaps between the extents in use are free, e.g. the extents of pages that moved before a crash
+    std::vector<Extent> used;
+    for (const auto &extent : extents_) {
+      if (extent.capacity_ > 0) {
+        used.push_back(extent);
+      }
+    }
+    std::sort(used.begin(), used.end(), [](const Extent &a, const Extent &b) { return a.offset_ < b.offset_; });
+    for (const auto &extent : used) {
+      if (extent.offset_ >= extents_end_ + EXTENT_ALIGNMENT) {
+        free_extents_.emplace(extent.offset_ - extents_end_, extents_end_);
+      }
+      extents_end_ = std::max(extents_end_, extent.offset_ + extent.capacity_);
+    }
+  }
+
+  // The free-space map is only created by the first deallocated page, so a database that never frees one has none.
+  free_map_name_ = file_name_.substr(0, n) + ".fsm";
+  if (new_file) {
+    // a map left behind by an earlier database file of the same name must not be applied to a new one
+    unlink(free_map_name_.c_str());
+  } else {
+    free_map_fd_ = open(free_map_name_.c_str(), O_RDWR);
+    if (free_map_fd_ < 0 && errno != ENOENT) {
+      throw Exception("can't open free-space map");
+    }
+  }
+  std::vector<uint8_t> free_map(free_map_fd_ >= 0 ? std::max(GetFileSize(free_map_name_), 0) : 0);
+  if (PositionalRead(free_map_fd_, reinterpret_cast<char *>(free_map.data()), free_map.size(), 0) < 0) {
+    throw Exception("can't read free-space map");
+  }
+  // Pages past the end of the file are not allocated anyway, and the buffer pool hands out their ids in order.
+  page_id_t num_pages = GetNumPages();
+  for (page_id_t page_id = 0; page_id < num_pages && static_cast<size_t>(page_id / 8) < free_map.size(); ++page_id) {
+    if ((free_map[page_id / 8] & (1 << (page_id % 8))) != 0) {
+      free_pages_.insert(free_pages_.end(), page_id);
+    }
+  }
+
+  if (backend_ == DiskIOBackend::POSIX_DIRECT) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    if (db_fd_ < 0 && errno == EINVAL) {
+      LOG_WARN("file system does not support O_DIRECT, falling back to buffered I/O");
+      backend_ = DiskIOBackend::POSIX;
+    } else if (db_fd_ < 0) {
+      throw Exception("can't open db file");
+    }
+  }
+  if (backend_ == DiskIOBackend::POSIX) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+    if (db_fd_ < 0) {
+      throw Exception("can't open db file");
+    }
+  }
+  if (db_fd_ >= 0) {
+    return;
+  }
+
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
   db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
   // directory or file does not exist
@@ -66,13 +226,16 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
       throw Exception("can't open db file");
     }
   }
-  buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() { CloseFiles(); }
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
+  shut_down_ = true;
+  CloseFiles();
   {
     std::scoped_lock scoped_db_io_latch(db_io_latch_);
     db_io_.close();
@@ -80,29 +243,205 @@ void DiskManager::ShutDown() {
   log_io_.close();
 }
 
+void DiskManager::CloseFiles() {
+  // Wait for the I/O in flight, so that no descriptor is closed, and maybe reused by another file, while in use.
+  std::scoped_lock close_latch(close_latch_);
+  std::unique_lock fd_latch(fd_latch_);
+  for (auto *fd : {&db_fd_, &free_map_fd_, &extent_fd_, &checksum_fd_}) {
+    if (int old_fd = fd->exchange(-1); old_fd >= 0) {
+      close(old_fd);
+    }
+  }
+}
+
+auto DiskManager::LockFiles() -> std::shared_lock<std::shared_mutex> {
+  if (shut_down_) {
+    // Wait until ShutDown has closed the descriptors instead of competing with it for fd_latch_, which readers could
+    // otherwise hold forever between them.
+    std::scoped_lock close_latch(close_latch_);
+  }
+  return std::shared_lock(fd_latch_);
+}
+
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  auto fd_latch = LockFiles();
+  WriteSinglePage(page_id, page_data);
+}
+
+auto DiskManager::WriteSinglePage(page_id_t page_id, const char *page_data) -> bool {
+  if (checksum_fd_ >= 0) {
+    std::memcpy(write_buffer, page_data, PAGE_SIZE);
+    page_data = write_buffer;
+  }
+  if (!WriteChecksums({page_id}, {page_data})) {
+    return false;
+  }
+  return WritePageData(page_id, page_data);
+}
+
+auto DiskManager::WritePageData(page_id_t page_id, const char *page_data) -> bool {
   size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
   num_writes_ += 1;
+  if (compressed_) {
+    return WriteCompressedPage(page_id, page_data);
+  }
+  if (backend_ != DiskIOBackend::FSTREAM) {
+    if (backend_ == DiskIOBackend::POSIX_DIRECT && !IsPageAligned(page_data)) {
+      std::memcpy(bounce_buffer, page_data, PAGE_SIZE);
+      page_data = bounce_buffer;
+    }
+    if (!PositionalWrite(db_fd_, page_data, PAGE_SIZE, offset)) {
+      LOG_DEBUG("I/O error while writing");
+      return false;
+    }
+    return true;
+  }
+
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  // set write cursor to offset
   db_io_.seekp(offset);
   db_io_.write(page_data, PAGE_SIZE);
   // check for I/O error
   if (db_io_.bad()) {
     LOG_DEBUG("I/O error while writing");
-    return;
+    return false;
   }
   // needs to flush to keep disk file in sync
   db_io_.flush();
+  return true;
+}
+
+auto DiskManager::WritePages(const std::vector<page_id_t> &page_ids, const std::vector<const char *> &page_data)
+    -> bool {
+  assert(page_ids.size() == page_data.size());
+  auto fd_latch = LockFiles();
+  std::vector<size_t> order(page_ids.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return page_ids[a] < page_ids[b]; });
+  std::vector<const char *> images(page_data);
+  auto free_copies = [](char *copies) { operator delete[](copies, std::align_val_t(PAGE_SIZE)); };
+  std::unique_ptr<char[], decltype(free_copies)> copies(nullptr, free_copies);
+  if (checksum_fd_ >= 0) {
+    // A page may change while it is written, e.g. by the page cleaner. It is written again later unless it is deleted
+    // first, so the image on disk must be the one its checksum was computed over.
+    copies.reset(new (std::align_val_t(PAGE_SIZE)) char[page_ids.size() * PAGE_SIZE]);
+    std::vector<page_id_t> sorted_ids;
+    std::vector<const char *> sorted_images;
+    for (size_t i : order) {
+      char *copy = copies.get() + sorted_ids.size() * PAGE_SIZE;
+      std::memcpy(copy, page_data[i], PAGE_SIZE);
+      images[i] = copy;
+      sorted_ids.push_back(page_ids[i]);
+      sorted_images.push_back(copy);
+    }
+    if (!WriteChecksums(sorted_ids, sorted_images)) {
+      return false;
+    }
+  }
+
+  bool written = true;
+  if (backend_ == DiskIOBackend::FSTREAM || compressed_) {
+    for (size_t i = 0; i < page_ids.size(); ++i) {
+      written = WritePageData(page_ids[i], images[i]) && written;
+    }
+    return written;
+  }
+
+  std::vector<struct iovec> iov;
+  size_t run_start = 0;
+  while (run_start < order.size()) {
+    // extend the run while page ids are consecutive and buffers can be used for direct I/O as is
+    iov.clear();
+    size_t run_end = run_start;
+    while (run_end < order.size() && iov.size() < IOV_MAX &&
+           page_ids[order[run_end]] == page_ids[order[run_start]] + static_cast<page_id_t>(run_end - run_start) &&
+           (backend_ != DiskIOBackend::POSIX_DIRECT || IsPageAligned(images[order[run_end]]))) {
+      iov.push_back({const_cast<char *>(images[order[run_end]]), PAGE_SIZE});
+      ++run_end;
+    }
+    if (iov.size() <= 1) {
+      written = WritePageData(page_ids[order[run_start]], images[order[run_start]]) && written;
+      run_start = std::max(run_end, run_start + 1);
+      continue;
+    }
+
+    off_t offset = static_cast<off_t>(page_ids[order[run_start]]) * PAGE_SIZE;
+    ssize_t write_count = pwritev(db_fd_, iov.data(), static_cast<int>(iov.size()), offset);
+    size_t done = iov.size();
+    if (write_count != static_cast<ssize_t>(iov.size()) * PAGE_SIZE) {
+      // partial or interrupted: finish the run page by page
+      done = write_count > 0 ? write_count / PAGE_SIZE : 0;
+      for (size_t i = run_start + done; i < run_end; ++i) {
+        written = WritePageData(page_ids[order[i]], images[order[i]]) && written;
+      }
+    }
+    num_writes_ += done;
+    run_start = run_end;
+  }
+  return written;
+}
+
+void DiskManager::Sync() {
+  auto fd_latch = LockFiles();
+  int db_fd = db_fd_;
+  if (db_fd < 0) {
+    // the stream has no descriptor of its own, but syncing any descriptor of the file covers its data
+    db_fd = open(file_name_.c_str(), O_RDONLY);
+  }
+  if (db_fd < 0 || fsync(db_fd) != 0) {
+    LOG_DEBUG("I/O error while syncing db file");
+  }
+  if (db_fd >= 0 && db_fd != db_fd_) {
+    close(db_fd);
+  }
+  for (const auto &fd : {checksum_fd_.load(), extent_fd_.load(), free_map_fd_.load()}) {
+    if (fd >= 0 && fsync(fd) != 0) {
+      LOG_DEBUG("I/O error while syncing");
+    }
+  }
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  auto fd_latch = LockFiles();
+  ReadPageUnchecked(page_id, page_data);
+  if (checksum_fd_ >= 0) {
+    PageChecksum checksum;
+    ReadChecksums(page_id, 1, &checksum);
+    VerifyChecksum(page_id, page_data, checksum);
+  }
+}
+
+void DiskManager::ReadPageUnchecked(page_id_t page_id, char *page_data) {
+  if (compressed_) {
+    ReadCompressedPage(page_id, page_data);
+    return;
+  }
+  if (backend_ != DiskIOBackend::FSTREAM) {
+    bool bounce = backend_ == DiskIOBackend::POSIX_DIRECT && !IsPageAligned(page_data);
+    char *target = bounce ? bounce_buffer : page_data;
+    ssize_t read_count = PositionalRead(db_fd_, target, PAGE_SIZE, static_cast<off_t>(page_id) * PAGE_SIZE);
+    if (read_count < 0) {
+      LOG_DEBUG("I/O error while reading");
+      return;
+    }
+    // tolerate reads past the end of the file, like the FSTREAM backend does
+    if (read_count < PAGE_SIZE) {
+      memset(target + read_count, 0, PAGE_SIZE - read_count);
+    }
+    if (bounce) {
+      std::memcpy(page_data, bounce_buffer, PAGE_SIZE);
+    }
+    return;
+  }
+
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
   int offset = page_id * PAGE_SIZE;
   // check if read beyond file length
@@ -128,6 +467,88 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   }
 }
 
+/**
+ * Read the contents of the specified pages, coalescing runs of consecutive pages into one preadv call
+ */
+void DiskManager::ReadPages(const std::vector<page_id_t> &page_ids, const std::vector<char *> &page_data) {
+  assert(page_ids.size() == page_data.size());
+  auto fd_latch = LockFiles();
+  std::vector<size_t> order(page_ids.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return page_ids[a] < page_ids[b]; });
+
+  if (backend_ == DiskIOBackend::FSTREAM || compressed_) {
+    for (size_t i = 0; i < page_ids.size(); ++i) {
+      ReadPageUnchecked(page_ids[i], page_data[i]);
+    }
+  } else {
+    ReadPagesUnchecked(page_ids, page_data, order);
+  }
+  if (checksum_fd_ < 0) {
+    return;
+  }
+
+  // Verify every page, reading the checksums of consecutive pages together, and only then report corruption.
+  std::vector<PageChecksum> checksums(page_ids.size());
+  size_t run_start = 0;
+  while (run_start < order.size()) {
+    size_t run_end = run_start + 1;
+    while (run_end < order.size() &&
+           page_ids[order[run_end]] == page_ids[order[run_start]] + static_cast<page_id_t>(run_end - run_start)) {
+      ++run_end;
+    }
+    ReadChecksums(page_ids[order[run_start]], run_end - run_start, &checksums[run_start]);
+    run_start = run_end;
+  }
+  std::optional<Exception> corruption;
+  for (size_t i = 0; i < order.size(); ++i) {
+    try {
+      VerifyChecksum(page_ids[order[i]], page_data[order[i]], checksums[i]);
+    } catch (const Exception &e) {
+      corruption.emplace(e);
+    }
+  }
+  if (corruption.has_value()) {
+    throw *corruption;
+  }
+}
+
+void DiskManager::ReadPagesUnchecked(const std::vector<page_id_t> &page_ids, const std::vector<char *> &page_data,
+                                     const std::vector<size_t> &order) {
+
+  std::vector<struct iovec> iov;
+  size_t run_start = 0;
+  while (run_start < order.size()) {
+    // extend the run while page ids are consecutive and buffers can be used for direct I/O as is
+    iov.clear();
+    size_t run_end = run_start;
+    while (run_end < order.size() && iov.size() < IOV_MAX &&
+           page_ids[order[run_end]] == page_ids[order[run_start]] + static_cast<page_id_t>(run_end - run_start) &&
+           (backend_ != DiskIOBackend::POSIX_DIRECT || IsPageAligned(page_data[order[run_end]]))) {
+      iov.push_back({page_data[order[run_end]], PAGE_SIZE});
+      ++run_end;
+    }
+    if (iov.size() <= 1) {
+      ReadPageUnchecked(page_ids[order[run_start]], page_data[order[run_start]]);
+      run_start = std::max(run_end, run_start + 1);
+      continue;
+    }
+
+    off_t offset = static_cast<off_t>(page_ids[order[run_start]]) * PAGE_SIZE;
+    ssize_t read_count = preadv(db_fd_, iov.data(), static_cast<int>(iov.size()), offset);
+    if (read_count != static_cast<ssize_t>(iov.size()) * PAGE_SIZE) {
+      // short read at the end of the file or interrupted: finish the run page by page
+      size_t done = read_count > 0 ? read_count / PAGE_SIZE : 0;
+      for (size_t i = run_start + done; i < run_end; ++i) {
+        ReadPageUnchecked(page_ids[order[i]], page_data[order[i]]);
+      }
+    }
+    run_start = run_end;
+  }
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
@@ -205,6 +626,296 @@ auto DiskManager::GetNumWrites() const -> int { return num_writes_; }
  */
 auto DiskManager::GetFlushState() const -> bool { return flush_log_; }
 
+auto DiskManager::WriteCompressedPage(page_id_t page_id, const char *page_data) -> bool {
+  // an image that does not save at least one byte is stored as is
+  size_t length = CompressionUtil::CompressZeroRuns(page_data, PAGE_SIZE, compression_buffer, PAGE_SIZE - 1);
+  const char *image = length == 0 ? page_data : compression_buffer;
+  length = length == 0 ? PAGE_SIZE : length;
+
+  Extent extent;
+  Extent old_extent{0, 0, 0};
+  bool moved = false;
+  {
+    std::scoped_lock extent_latch(extent_latch_);
+    if (static_cast<size_t>(page_id) >= extents_.size()) {
+      extents_.resize(page_id + 1, Extent{0, 0, 0});
+    }
+    extent = extents_[page_id];
+    if (extent.capacity_ < length) {
+      // the old extent still holds the page until the new one is published
+      old_extent = extent;
+      moved = true;
+      extent.capacity_ = (length + EXTENT_ALIGNMENT - 1) / EXTENT_ALIGNMENT * EXTENT_ALIGNMENT;
+      auto free_extent = free_extents_.lower_bound(extent.capacity_);
+      if (free_extent != free_extents_.end()) {
+        extent.offset_ = free_extent->second;
+        if (free_extent->first > extent.capacity_) {
+          free_extents_.emplace(free_extent->first - extent.capacity_, extent.offset_ + extent.capacity_);
+        }
+        free_extents_.erase(free_extent);
+      } else {
+        extent.offset_ = extents_end_;
+        extents_end_ += extent.capacity_;
+      }
+    }
+  }
+  bool publish = moved || extent.length_ != length;
+  extent.length_ = length;
+
+  // A moved image must be durable before the extent pointing at it is, or a crash could leave the extent pointing at
+  // whatever was there before. A page rewritten in place only records its new length, which Sync orders with the
+  // image like any other write.
+  if (!PositionalWrite(db_fd_, image, length, extent.offset_) || (moved && fdatasync(db_fd_) != 0)) {
+    LOG_DEBUG("I/O error while writing");
+    return false;
+  }
+  if (publish && (!PositionalWrite(extent_fd_, reinterpret_cast<const char *>(&extent), sizeof(extent),
+                                   static_cast<off_t>(page_id) * sizeof(extent)) ||
+                  (old_extent.capacity_ > 0 && fdatasync(extent_fd_) != 0))) {
+    LOG_DEBUG("I/O error while writing extent");
+    return false;
+  }
+  std::scoped_lock extent_latch(extent_latch_);
+  if (static_cast<size_t>(page_id) < extents_.size()) {
+    extents_[page_id] = extent;
+  }
+  if (old_extent.capacity_ > 0) {
+    free_extents_.emplace(old_extent.capacity_, old_extent.offset_);
+  }
+  return true;
+}
+
+void DiskManager::ReadCompressedPage(page_id_t page_id, char *page_data) {
+  Extent extent{0, 0, 0};
+  {
+    std::scoped_lock extent_latch(extent_latch_);
+    if (static_cast<size_t>(page_id) < extents_.size()) {
+      extent = extents_[page_id];
+    }
+  }
+  if (extent.capacity_ == 0) {
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+
+  char *image = extent.length_ == PAGE_SIZE ? page_data : compression_buffer;
+  if (PositionalRead(db_fd_, image, extent.length_, extent.offset_) != static_cast<ssize_t>(extent.length_)) {
+    LOG_DEBUG("I/O error while reading");
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  if (image != page_data && !CompressionUtil::DecompressZeroRuns(image, extent.length_, page_data, PAGE_SIZE)) {
+    // leave it to the checksum to report the page
+    LOG_DEBUG("malformed compressed page");
+    memset(page_data, 0, PAGE_SIZE);
+  }
+}
+
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  auto fd_latch = LockFiles();
+  std::scoped_lock free_map_latch(free_map_latch_);
+  if (free_pages_.insert(page_id).second) {
+    if (free_page_stride_ > 0) {
+      free_pages_by_offset_[page_id % free_page_stride_].insert(page_id);
+    }
+    WriteFreeMapByte(page_id);
+  }
+}
+
+auto DiskManager::ReuseFreePage(uint32_t stride, uint32_t offset) -> page_id_t {
+  auto fd_latch = LockFiles();
+  std::scoped_lock free_map_latch(free_map_latch_);
+  if (stride != free_page_stride_) {
+    // all buffer pool instances use the same stride, so the free pages are split by residue once
+    free_page_stride_ = stride;
+    free_pages_by_offset_.assign(stride, {});
+    for (page_id_t page_id : free_pages_) {
+      free_pages_by_offset_[page_id % stride].insert(free_pages_by_offset_[page_id % stride].end(), page_id);
+    }
+  }
+  auto &free_pages = free_pages_by_offset_[offset];
+  if (free_pages.empty()) {
+    return INVALID_PAGE_ID;
+  }
+  page_id_t page_id = *free_pages.begin();
+  free_pages.erase(free_pages.begin());
+  free_pages_.erase(page_id);
+  WriteFreeMapByte(page_id);
+  return page_id;
+}
+
+auto DiskManager::GetNumPages() -> page_id_t {
+  if (compressed_) {
+    std::scoped_lock extent_latch(extent_latch_);
+    return static_cast<page_id_t>(extents_.size());
+  }
+  return (std::max(GetFileSize(file_name_), 0) + PAGE_SIZE - 1) / PAGE_SIZE;
+}
+
+auto DiskManager::TruncateFreePages() -> page_id_t {
+  auto fd_latch = LockFiles();
+  std::scoped_lock free_map_latch(free_map_latch_);
+  page_id_t num_pages = GetNumPages();
+  page_id_t new_num_pages = num_pages;
+  while (new_num_pages > 0 && free_pages_.erase(new_num_pages - 1) > 0) {
+    --new_num_pages;
+    if (free_page_stride_ > 0) {
+      free_pages_by_offset_[new_num_pages % free_page_stride_].erase(new_num_pages);
+    }
+  }
+  if (new_num_pages == num_pages) {
+    return 0;
+  }
+
+  // The database file goes first: should the rest not happen, reopening ignores free pages past its end.
+  off_t file_size = static_cast<off_t>(new_num_pages) * PAGE_SIZE;
+  if (compressed_) {
+    std::scoped_lock extent_latch(extent_latch_);
+    for (size_t i = new_num_pages; i < extents_.size(); ++i) {
+      if (extents_[i].capacity_ > 0) {
+        free_extents_.emplace(extents_[i].capacity_, extents_[i].offset_);
+      }
+    }
+    extents_.resize(new_num_pages);
+    extents_end_ = 0;
+    for (const auto &extent : extents_) {
+      extents_end_ = std::max(extents_end_, extent.offset_ + extent.capacity_);
+    }
+    // free extents past the last extent in use go with the end of the file
+    for (auto iter = free_extents_.begin(); iter != free_extents_.end();) {
+      iter = iter->second >= extents_end_ ? free_extents_.erase(iter) : std::next(iter);
+    }
+    file_size = static_cast<off_t>(extents_end_);
+  }
+  if (truncate(file_name_.c_str(), file_size) != 0) {
+    throw Exception("can't truncate db file");
+  }
+  if (extent_fd_ >= 0 && ftruncate(extent_fd_, static_cast<off_t>(new_num_pages) * sizeof(Extent)) != 0) {
+    throw Exception("can't truncate extent file");
+  }
+  if (checksum_fd_ >= 0) {
+    std::scoped_lock checksum_latch(checksum_latch_);
+    if (checksums_.size() > static_cast<size_t>(new_num_pages)) {
+      checksums_.resize(new_num_pages);
+      if (ftruncate(checksum_fd_, static_cast<off_t>(new_num_pages) * sizeof(PageChecksum)) != 0) {
+        throw Exception("can't truncate checksum file");
+      }
+    }
+  }
+  if (free_map_fd_ >= 0 && ftruncate(free_map_fd_, (new_num_pages + 7) / 8) != 0) {
+    throw Exception("can't truncate free-space map");
+  }
+  if (new_num_pages % 8 != 0) {
+    WriteFreeMapByte(new_num_pages - 1);
+  }
+  return num_pages - new_num_pages;
+}
+
+void DiskManager::WriteFreeMapByte(page_id_t page_id) {
+  page_id_t first = page_id / 8 * 8;
+  uint8_t byte = 0;
+  for (auto iter = free_pages_.lower_bound(first); iter != free_pages_.end() && *iter < first + 8; ++iter) {
+    byte |= 1 << (*iter - first);
+  }
+  if (free_map_fd_ < 0 && !shut_down_) {
+    free_map_fd_ = open(free_map_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (!PositionalWrite(free_map_fd_, reinterpret_cast<const char *>(&byte), 1, page_id / 8)) {
+    LOG_DEBUG("I/O error while writing free-space map");
+  }
+}
+
+/**
+ * Returns number of pages read that did not match their checksum
+ */
+auto DiskManager::GetNumChecksumFailures() const -> int { return num_checksum_failures_; }
+
+auto DiskManager::WriteChecksums(const std::vector<page_id_t> &page_ids, const std::vector<const char *> &page_data)
+    -> bool {
+  if (checksum_fd_ < 0) {
+    return true;
+  }
+  uint64_t write_number;
+  {
+    // Held across the update and the write of the file, so that concurrent writers of a page neither lose each other's
+    // image nor leave an older entry in the file than in memory.
+    std::scoped_lock checksum_latch(checksum_latch_);
+    size_t run_start = 0;
+    for (size_t i = 0; i < page_ids.size(); ++i) {
+      auto index = static_cast<size_t>(page_ids[i]);
+      if (index >= checksums_.size()) {
+        checksums_.resize(index + 1, PageChecksum{{0, 0}, 0});
+      }
+      PageChecksum &checksum = checksums_[index];
+      if (checksum.present_ == 0) {
+        // The page was written without a checksum, or never. Read what is on disk now, zeros past the end of the file.
+        // The bounce buffer is free, writes only fill it after their checksums are stored.
+        std::memset(bounce_buffer, 0, PAGE_SIZE);
+        ReadPageUnchecked(page_ids[i], bounce_buffer);
+        checksum.crc_[0] = ChecksumUtil::Crc32c(bounce_buffer, PAGE_SIZE);
+        checksum.present_ = 1;
+      }
+      checksum.crc_[1] = checksum.crc_[0];
+      checksum.crc_[0] = ChecksumUtil::Crc32c(page_data[i], PAGE_SIZE);
+      checksum.present_ = (checksum.present_ & 1) << 1 | 1;
+
+      if (i + 1 < page_ids.size() && page_ids[i + 1] == page_ids[i] + 1) {
+        continue;
+      }
+      if (!PositionalWrite(checksum_fd_, reinterpret_cast<const char *>(&checksums_[page_ids[run_start]]),
+                           (i + 1 - run_start) * sizeof(PageChecksum),
+                           static_cast<off_t>(page_ids[run_start]) * sizeof(PageChecksum))) {
+        LOG_DEBUG("I/O error while writing checksum");
+        return false;
+      }
+      run_start = i + 1;
+    }
+    write_number = ++checksum_writes_;
+  }
+
+  // The checksums must be on disk before the page can be torn, or a torn page could not be told from a good one. A
+  // sync started after our write covers it, so writers waiting here share the sync of whoever goes first.
+  std::scoped_lock checksum_sync_latch(checksum_sync_latch_);
+  if (checksum_writes_synced_ >= write_number) {
+    return true;
+  }
+  uint64_t writes;
+  {
+    std::scoped_lock checksum_latch(checksum_latch_);
+    writes = checksum_writes_;
+  }
+  if (fdatasync(checksum_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing checksum file");
+    return false;
+  }
+  checksum_writes_synced_ = writes;
+  return true;
+}
+
+void DiskManager::ReadChecksums(page_id_t page_id, size_t count, PageChecksum *checksums) {
+  std::scoped_lock checksum_latch(checksum_latch_);
+  for (size_t i = 0; i < count; ++i) {
+    // pages past the end of the checksum file were never written with a checksum
+    size_t index = page_id + i;
+    checksums[i] = index < checksums_.size() ? checksums_[index] : PageChecksum{{0, 0}, 0};
+  }
+}
+
+void DiskManager::VerifyChecksum(page_id_t page_id, const char *page_data, const PageChecksum &checksum) {
+  if (checksum.present_ == 0) {
+    return;
+  }
+  uint32_t crc = ChecksumUtil::Crc32c(page_data, PAGE_SIZE);
+  for (int i = 0; i < 2; ++i) {
+    if ((checksum.present_ & (1 << i)) != 0 && checksum.crc_[i] == crc) {
+      return;
+    }
+  }
+  num_checksum_failures_ += 1;
+  throw Exception(ExceptionType::DATA_CORRUPTION,
+                  "page " + std::to_string(page_id) + " of " + file_name_ + " does not match its checksum");
+}
+
 /**
  * Private helper function to get disk file size
  */
@@ -9,8 +9,14 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstring>
+#include <mutex>  // NOLINT
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "common/config.h"
 #include "common/exception.h"
 #include "common/logger.h"
 #include "common/rid.h"
@@ -43,22 +49,40 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return root_page_id_ == INVALID_P
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) -> bool {
-  rwlatch_.RLock();
-  if (IsEmpty()) {
-    rwlatch_.RUnlock();
-    return false;
+  if (enable_optimistic_lock_coupling) {
+    while (true) {
+      uint64_t version;
+      BasicPageGuard guard = FindLeafPageOptimistic(key, &version);
+      if (!guard.IsValid()) {
+        if (IsEmpty()) {
+          return false;
+        }
+        continue;
+      }
+
+      // A writer may be changing the leaf, so search a copy of it, and only once the copy is known to be whole.
+      alignas(LeafPage) char leaf_data[PAGE_SIZE];
+      memcpy(leaf_data, guard.GetData(), PAGE_SIZE);
+      if (!guard.GetPage()->ValidateVersion(version)) {
+        continue;
+      }
+      auto *leaf_node = reinterpret_cast<LeafPage *>(leaf_data);
+      ValueType value;
+      bool is_found = leaf_node->Lookup(key, &value, comparator_);
+      if (is_found) {
+        result->push_back(value);
+      }
+      return is_found;
+    }
   }
 
-  Page *leaf_page = FindLeafPage(key);
-  auto *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+  ReadPageGuard leaf_guard = FindLeafPage(key);
+  if (!leaf_guard.IsValid()) {
+    return false;
+  }
 
   ValueType value;
-  bool is_find = leaf_node->Lookup(key, &value, comparator_);
-
-  leaf_page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
-
-  if (!is_find) {
+  if (!leaf_guard.As<LeafPage>()->Lookup(key, &value, comparator_)) {
     return false;
   }
 
@@ -78,15 +102,43 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  rwlatch_.WLock();
-  if (IsEmpty()) {
-    StartNewTree(key, value);
-    rwlatch_.WUnlock();
+  while (true) {
+    if (IsEmpty()) {
+      std::scoped_lock root_latch(root_latch_);
+      if (IsEmpty()) {
+        StartNewTree(key, value);
+        return true;
+      }
+    }
 
-    return true;
-  }
+    // Optimistic pass: only the leaf is write-latched, which is enough as long as it doesn't split.
+    WritePageGuard leaf_guard = FindLeafPageForWrite(key);
+    if (!leaf_guard.IsValid()) {
+      continue;
+    }
 
-  return InsertIntoLeaf(key, value, transaction);
+    auto *leaf_node = reinterpret_cast<LeafPage *>(leaf_guard.GetPage()->GetData());
+    if (leaf_node->GetSize() + 1 < leaf_node->GetMaxSize()) {
+      int size = leaf_node->GetSize();
+      if (leaf_node->Insert(key, value, comparator_) == size) {
+        return false;
+      }
+      leaf_guard.SetDirty();
+      return true;
+    }
+
+    ValueType old_value;
+    if (leaf_node->Lookup(key, &old_value, comparator_)) {
+      return false;
+    }
+    leaf_guard.Drop();
+
+    // Pessimistic pass: the leaf has to split, so crab down from the root with write latches.
+    WritePageGuard root_guard = LatchRootForWrite();
+    if (root_guard.IsValid()) {
+      return InsertIntoLeaf(key, value, std::move(root_guard), transaction);
+    }
+  }
 }
 /*
  * Insert constant key & value pair into an empty tree
@@ -97,40 +149,156 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
   page_id_t page_id;
-  Page *page = buffer_pool_manager_->NewPage(&page_id);
-  if (page == nullptr) {
+  BasicPageGuard guard = buffer_pool_manager_->NewPageGuarded(&page_id);
+  if (!guard.IsValid()) {
     throw std::runtime_error("out of memory");
   }
 
-  auto root_node = reinterpret_cast<LeafPage *>(page->GetData());
+  auto root_node = guard.AsMut<LeafPage>();
   root_node->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
   root_node->Insert(key, value, comparator_);
 
   root_page_id_ = page_id;
   UpdateRootPageId(1);
-
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::StartNewRoot(BPlusTreePage *left_node, const KeyType &key, BPlusTreePage *right_node) {
   page_id_t page_id;
-  Page *page = buffer_pool_manager_->NewPage(&page_id);
-  if (page == nullptr) {
+  BasicPageGuard guard = buffer_pool_manager_->NewPageGuarded(&page_id);
+  if (!guard.IsValid()) {
     throw std::runtime_error("out of memory");
   }
 
   left_node->SetParentPageId(page_id);
   right_node->SetParentPageId(page_id);
 
-  auto root_node = reinterpret_cast<InternalPage *>(page->GetData());
+  auto root_node = guard.AsMut<InternalPage>();
   root_node->Init(page_id, INVALID_PAGE_ID, internal_max_size_);
   root_node->PopulateNewRoot(left_node->GetPageId(), key, right_node->GetPageId());
   root_page_id_ = page_id;
   UpdateRootPageId(0);
+}
+/*
+ * Build an empty b+ tree bottom-up from key & value pairs, instead of
+ * inserting them one by one. Leaves are filled in key order up to
+ * fill_factor of their capacity and chained together, and every internal
+ * page is completed as soon as its last child is, so only one page per level
+ * is pinned at a time.
+ * @parameter: entries      sorted first unless they already are; only the
+ * first value of a key is kept, as Insert would
+ * @return: false if the tree is not empty, in which case nothing is loaded
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoad(std::vector<std::pair<KeyType, ValueType>> *entries, double fill_factor) -> bool {
+  auto less = [this](const auto &a, const auto &b) { return comparator_(a.first, b.first) < 0; };
+  if (!std::is_sorted(entries->begin(), entries->end(), less)) {
+    std::stable_sort(entries->begin(), entries->end(), less);
+  }
+  auto equal = [this](const auto &a, const auto &b) { return comparator_(a.first, b.first) == 0; };
+  entries->erase(std::unique(entries->begin(), entries->end(), equal), entries->end());
 
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  // Holding the latch keeps inserts into the empty tree out until the new root is published.
+  std::scoped_lock root_latch(root_latch_);
+  if (!IsEmpty()) {
+    return false;
+  }
+  if (entries->empty()) {
+    return true;
+  }
+
+  // Plan how many pages every level has, bottom-up, so that the entries of a level can be spread over its pages
+  // evenly in a single pass, and no page ends up below its min size unless the level has just one.
+  auto page_count = [fill_factor](size_t count, size_t min_size, size_t max_size) {
+    size_t per_page = std::clamp(static_cast<size_t>(fill_factor * max_size), min_size, max_size);
+    size_t pages = (count + per_page - 1) / per_page;
+    if (pages > 1 && count / pages < min_size && (count + pages - 2) / (pages - 1) <= max_size) {
+      pages--;
+    }
+    return pages;
+  };
+  // A leaf splits once it reaches its max size, and an internal page once it exceeds it.
+  std::vector<size_t> totals{entries->size()};
+  std::vector<size_t> page_counts{page_count(entries->size(), std::max(leaf_max_size_ / 2, 1),
+                                             std::max(leaf_max_size_ - 1, 1))};
+  while (page_counts.back() > 1) {
+    totals.push_back(page_counts.back());
+    page_counts.push_back(page_count(totals.back(), std::max((internal_max_size_ + 1) / 2, 2),
+                                     std::max(internal_max_size_, 2)));
+  }
+  auto target_size = [&](size_t level, size_t index) {
+    return static_cast<int>(totals[level] / page_counts[level] + (index < totals[level] % page_counts[level] ? 1 : 0));
+  };
+
+  // The internal page being filled on every level, the smallest key below it, and how many pages came before it.
+  std::vector<BasicPageGuard> parents(page_counts.size());
+  std::vector<KeyType> parent_keys(page_counts.size());
+  std::vector<size_t> parent_indexes(page_counts.size(), 0);
+  page_id_t root_page_id = INVALID_PAGE_ID;
+
+  // Hand a completed page over to its parent, completing the parent in turn if that was its last child.
+  auto complete = [&](BasicPageGuard child_guard, KeyType key) {
+    for (size_t level = 1; level < page_counts.size(); level++) {
+      if (!parents[level].IsValid()) {
+        page_id_t page_id;
+        parents[level] = buffer_pool_manager_->NewPageGuarded(&page_id);
+        if (!parents[level].IsValid()) {
+          throw std::runtime_error("out of memory");
+        }
+        parents[level].AsMut<InternalPage>()->Init(page_id, INVALID_PAGE_ID, internal_max_size_);
+        parent_keys[level] = key;
+      }
+
+      auto *parent_node = parents[level].AsMut<InternalPage>();
+      child_guard.AsMut<BPlusTreePage>()->SetParentPageId(parent_node->GetPageId());
+      int index = parent_node->GetSize();
+      if (index > 0) {
+        parent_node->SetKeyAt(index, key);
+      }
+      parent_node->SetValueAt(index, child_guard.PageId());
+      parent_node->IncreaseSize(1);
+      child_guard.Drop();
+
+      if (parent_node->GetSize() < target_size(level, parent_indexes[level])) {
+        return;
+      }
+      child_guard = std::move(parents[level]);
+      key = parent_keys[level];
+      parent_indexes[level]++;
+    }
+    root_page_id = child_guard.PageId();
+  };
+
+  BasicPageGuard prev_guard;
+  KeyType prev_key;
+  size_t offset = 0;
+  for (size_t i = 0; i < page_counts[0]; i++) {
+    page_id_t page_id;
+    BasicPageGuard guard = buffer_pool_manager_->NewPageGuarded(&page_id);
+    if (!guard.IsValid()) {
+      throw std::runtime_error("out of memory");
+    }
+    auto *leaf_node = guard.AsMut<LeafPage>();
+    leaf_node->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+    int size = target_size(0, i);
+    leaf_node->CopyNFrom(entries->data() + offset, size);
+
+    // The previous leaf is only completed once it can point at this one.
+    if (prev_guard.IsValid()) {
+      prev_guard.AsMut<LeafPage>()->SetNextPageId(page_id);
+      complete(std::move(prev_guard), prev_key);
+    }
+    prev_guard = std::move(guard);
+    prev_key = (*entries)[offset].first;
+    offset += size;
+  }
+  complete(std::move(prev_guard), prev_key);
+
+  root_page_id_ = root_page_id;
+  UpdateRootPageId(1);
+  return true;
 }
+
 /*
  * Insert constant key & value pair into leaf page
  * User needs to first find the right leaf page as insertion target, then look
@@ -140,87 +308,47 @@ void BPLUSTREE_TYPE::StartNewRoot(BPlusTreePage *left_node, const KeyType &key,
  * keys return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  bool is_root_latched = true;
-
-  page_id_t page_id = root_page_id_;
-  Page *page = buffer_pool_manager_->FetchPage(page_id);
-  page->WLatch();
+auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, WritePageGuard root_guard,
+                                    Transaction *transaction) -> bool {
+  // Write latches of the ancestors that may still be modified by a split, released once a safe node is reached.
+  // The root stays among them until then, which keeps root_page_id_ from changing under anyone else.
+  std::vector<WritePageGuard> ancestors;
 
-  auto *curr_node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  WritePageGuard guard = std::move(root_guard);
+  auto *curr_node = guard.As<BPlusTreePage>();
 
   while (!curr_node->IsLeafPage()) {
-    auto *node = reinterpret_cast<InternalPage *>(page->GetData());
-    page_id = node->Lookup(key, comparator_);
-
-    transaction->AddIntoPageSet(page);
-
-    page = buffer_pool_manager_->FetchPage(page_id);
-    page->WLatch();
+    page_id_t page_id = guard.As<InternalPage>()->Lookup(key, comparator_);
 
-    curr_node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    ancestors.push_back(std::move(guard));
+    guard = buffer_pool_manager_->FetchPageWrite(page_id);
+    curr_node = guard.As<BPlusTreePage>();
 
     if (curr_node->GetSize() + 1 < curr_node->GetMaxSize()) {
-      if (is_root_latched) {
-        is_root_latched = false;
-        rwlatch_.WUnlock();
-      }
-
-      for (Page *pg : *transaction->GetPageSet()) {
-        pg->WUnlatch();
-        buffer_pool_manager_->UnpinPage(pg->GetPageId(), false);
-      }
-      transaction->GetPageSet()->clear();
+      ancestors.clear();
     }
   }
 
-  auto leaf_node = reinterpret_cast<LeafPage *>(page->GetData());
+  auto leaf_node = reinterpret_cast<LeafPage *>(guard.GetPage()->GetData());
 
   int size = leaf_node->GetSize();
   if (leaf_node->Insert(key, value, comparator_) == size) {
-    if (is_root_latched) {
-      is_root_latched = false;
-      rwlatch_.WUnlock();
-    }
-
-    for (Page *pg : *transaction->GetPageSet()) {
-      pg->WUnlatch();
-      buffer_pool_manager_->UnpinPage(pg->GetPageId(), false);
-    }
-    transaction->GetPageSet()->clear();
-
-    page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-
     return false;
   }
+  guard.SetDirty();
 
   if (leaf_node->GetSize() == leaf_node->GetMaxSize()) {
     LeafPage *left_node = leaf_node;
-    LeafPage *right_node = SplitLeafNode(left_node);
+    BasicPageGuard right_guard = SplitLeafNode(left_node);
+    auto *right_node = right_guard.AsMut<LeafPage>();
 
     if (left_node->IsRootPage()) {
       StartNewRoot(left_node, right_node->KeyAt(0), right_node);
     } else {
       InsertIntoParent(left_node, right_node->KeyAt(0), right_node, transaction);
     }
-
-    buffer_pool_manager_->UnpinPage(right_node->GetPageId(), true);
   }
 
-  if (is_root_latched) {
-    is_root_latched = false;
-    rwlatch_.WUnlock();
-  }
-
-  for (Page *pg : *transaction->GetPageSet()) {
-    pg->WUnlatch();
-    buffer_pool_manager_->UnpinPage(pg->GetPageId(), false);
-  }
-  transaction->GetPageSet()->clear();
-
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
   return true;
 }
 
@@ -238,35 +366,35 @@ auto BPLUSTREE_TYPE::Split(N *node) -> N * {
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::SplitLeafNode(LeafPage *left_node) -> LeafPage * {
+auto BPLUSTREE_TYPE::SplitLeafNode(LeafPage *left_node) -> BasicPageGuard {
   page_id_t page_id;
-  Page *page = buffer_pool_manager_->NewPage(&page_id);
-  if (page == nullptr) {
+  BasicPageGuard guard = buffer_pool_manager_->NewPageGuarded(&page_id);
+  if (!guard.IsValid()) {
     throw std::runtime_error("out of memory");
   }
 
-  auto *right_node = reinterpret_cast<LeafPage *>(page->GetData());
+  auto *right_node = guard.AsMut<LeafPage>();
   right_node->Init(page_id, left_node->GetParentPageId(), left_node->GetMaxSize());
   left_node->MoveHalfTo(right_node);
   right_node->SetNextPageId(left_node->GetNextPageId());
   left_node->SetNextPageId(right_node->GetPageId());
 
-  return right_node;
+  return guard;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::SplitInternalNode(InternalPage *left_node) -> InternalPage * {
+auto BPLUSTREE_TYPE::SplitInternalNode(InternalPage *left_node) -> BasicPageGuard {
   page_id_t page_id;
-  Page *page = buffer_pool_manager_->NewPage(&page_id);
-  if (page == nullptr) {
+  BasicPageGuard guard = buffer_pool_manager_->NewPageGuarded(&page_id);
+  if (!guard.IsValid()) {
     throw std::runtime_error("out of memory");
   }
 
-  auto *right_node = reinterpret_cast<InternalPage *>(page->GetData());
+  auto *right_node = guard.AsMut<InternalPage>();
   right_node->Init(page_id, left_node->GetParentPageId(), left_node->GetMaxSize());
   left_node->MoveHalfTo(right_node, buffer_pool_manager_);
 
-  return right_node;
+  return guard;
 }
 
 /*
@@ -281,28 +409,22 @@ auto BPLUSTREE_TYPE::SplitInternalNode(InternalPage *left_node) -> InternalPage
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
                                       Transaction *transaction) {
-  // Page *page = transaction->GetPageSet()->back();
-  // transaction->GetPageSet()->pop_back();
-
-  Page *page = buffer_pool_manager_->FetchPage(old_node->GetParentPageId());
-  auto internal_node = reinterpret_cast<InternalPage *>(page->GetData());
+  // The parent is already write-latched by the caller, which still holds it among its ancestors.
+  BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(old_node->GetParentPageId());
+  auto internal_node = guard.AsMut<InternalPage>();
   internal_node->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
 
   if (internal_node->GetSize() == internal_node->GetMaxSize()) {
     InternalPage *left_node = internal_node;
-    InternalPage *right_node = SplitInternalNode(left_node);
+    BasicPageGuard right_guard = SplitInternalNode(left_node);
+    auto *right_node = right_guard.AsMut<InternalPage>();
 
     if (left_node->IsRootPage()) {
       StartNewRoot(left_node, right_node->KeyAt(0), right_node);
     } else {
       InsertIntoParent(left_node, right_node->KeyAt(0), right_node, transaction);
     }
-
-    buffer_pool_manager_->UnpinPage(right_node->GetPageId(), true);
   }
-
-  // page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
 }
 
 /*****************************************************************************
@@ -317,89 +439,70 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
-  rwlatch_.WLock();
-  bool is_root_latched = true;
-
-  if (IsEmpty()) {
-    rwlatch_.WUnlock();
+  // Optimistic pass: only the leaf is write-latched, which is enough as long as it doesn't underflow.
+  WritePageGuard guard = FindLeafPageForWrite(key);
+  if (!guard.IsValid()) {
     return;
   }
 
-  page_id_t page_id = root_page_id_;
-  Page *page = buffer_pool_manager_->FetchPage(page_id);
-  page->WLatch();
+  auto *leaf_node = reinterpret_cast<LeafPage *>(guard.GetPage()->GetData());
+  if (leaf_node->GetSize() > leaf_node->GetMinSize()) {
+    int size = leaf_node->GetSize();
+    if (leaf_node->RemoveAndDeleteRecord(key, comparator_) != size) {
+      guard.SetDirty();
+    }
+    return;
+  }
 
-  auto *curr_node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  ValueType value;
+  if (!leaf_node->Lookup(key, &value, comparator_)) {
+    return;
+  }
+  guard.Drop();
 
-  while (!curr_node->IsLeafPage()) {
-    auto *node = reinterpret_cast<InternalPage *>(page->GetData());
-    page_id = node->Lookup(key, comparator_);
+  // Pessimistic pass: the leaf may have to be merged, so crab down from the root with write latches.
+  guard = LatchRootForWrite();
+  if (!guard.IsValid()) {
+    return;
+  }
 
-    transaction->AddIntoPageSet(page);
+  // Write latches of the ancestors that may still be modified by a merge, released once a safe node is reached.
+  // The root stays among them until then, which keeps root_page_id_ from changing under anyone else.
+  std::vector<WritePageGuard> ancestors;
+  auto *curr_node = guard.As<BPlusTreePage>();
 
-    page = buffer_pool_manager_->FetchPage(page_id);
-    page->WLatch();
+  while (!curr_node->IsLeafPage()) {
+    page_id_t page_id = guard.As<InternalPage>()->Lookup(key, comparator_);
 
-    curr_node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    ancestors.push_back(std::move(guard));
+    guard = buffer_pool_manager_->FetchPageWrite(page_id);
+    curr_node = guard.As<BPlusTreePage>();
 
     if (curr_node->GetSize() > curr_node->GetMinSize()) {
-      if (is_root_latched) {
-        is_root_latched = false;
-        rwlatch_.WUnlock();
-      }
-
-      for (Page *pg : *transaction->GetPageSet()) {
-        pg->WUnlatch();
-        buffer_pool_manager_->UnpinPage(pg->GetPageId(), false);
-      }
-      transaction->GetPageSet()->clear();
+      ancestors.clear();
     }
   }
 
-  auto *leaf_node = reinterpret_cast<LeafPage *>(page->GetData());
+  leaf_node = reinterpret_cast<LeafPage *>(guard.GetPage()->GetData());
 
+  // Pages emptied by merges. They are kept here rather than in the transaction, which may be null.
+  std::vector<page_id_t> deleted_pages;
   int size = leaf_node->GetSize();
-  if (leaf_node->RemoveAndDeleteRecord(key, comparator_) == size) {
-    if (is_root_latched) {
-      is_root_latched = false;
-      rwlatch_.WUnlock();
-    }
+  if (leaf_node->RemoveAndDeleteRecord(key, comparator_) != size) {
+    guard.SetDirty();
 
-    for (Page *pg : *transaction->GetPageSet()) {
-      pg->WUnlatch();
-      buffer_pool_manager_->UnpinPage(pg->GetPageId(), false);
+    if (leaf_node->GetSize() < leaf_node->GetMinSize()) {
+      AdjustLeafNode(leaf_node, key, &deleted_pages);
     }
-    transaction->GetPageSet()->clear();
-
-    page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-
-    return;
   }
 
-  if (leaf_node->GetSize() < leaf_node->GetMinSize()) {
-    AdjustLeafNode(leaf_node, key, transaction);
-  }
+  // Every latch and pin has to be released before the emptied pages can be deleted.
+  ancestors.clear();
+  guard.Drop();
 
-  if (is_root_latched) {
-    is_root_latched = false;
-    rwlatch_.WUnlock();
-  }
-
-  for (Page *pg : *transaction->GetPageSet()) {
-    pg->WUnlatch();
-    buffer_pool_manager_->UnpinPage(pg->GetPageId(), false);
-  }
-  transaction->GetPageSet()->clear();
-
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
-
-  for (auto page_id : *transaction->GetDeletedPageSet()) {
+  for (auto page_id : deleted_pages) {
     buffer_pool_manager_->DeletePage(page_id);
-    // std::this_thread::sleep_for(std::chrono::milliseconds(5));
   }
-  transaction->GetDeletedPageSet()->clear();
 }
 
 /*
@@ -416,26 +519,26 @@ auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::AdjustLeafNode(LeafPage *leaf_node, const KeyType &key, Transaction *transaction) {
+void BPLUSTREE_TYPE::AdjustLeafNode(LeafPage *leaf_node, const KeyType &key, std::vector<page_id_t> *deleted_pages) {
   if (leaf_node->IsRootPage()) {
     if (leaf_node->GetSize() == 0) {
       root_page_id_ = INVALID_PAGE_ID;
       UpdateRootPageId(0);
 
-      transaction->AddIntoDeletedPageSet(leaf_node->GetPageId());
+      deleted_pages->push_back(leaf_node->GetPageId());
     }
 
     return;
   }
 
-  Page *parent_page = buffer_pool_manager_->FetchPage(leaf_node->GetParentPageId());
-  auto parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  // The parent is already write-latched by the caller, which still holds it among its ancestors.
+  BasicPageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(leaf_node->GetParentPageId());
+  auto parent_node = parent_guard.AsMut<InternalPage>();
   int index = parent_node->KeyIndex(key, comparator_);
 
   if (index - 1 >= 0) {
-    Page *left_neigh_page = buffer_pool_manager_->FetchPage(parent_node->ValueAt(index - 1));
-    left_neigh_page->WLatch();
-    auto left_neigh_node = reinterpret_cast<LeafPage *>(left_neigh_page->GetData());
+    WritePageGuard left_neigh_guard = buffer_pool_manager_->FetchPageWrite(parent_node->ValueAt(index - 1));
+    auto left_neigh_node = left_neigh_guard.AsMut<LeafPage>();
 
     if (left_neigh_node->GetSize() > left_neigh_node->GetMinSize()) {
       left_neigh_node->MoveLastToFrontOf(leaf_node);
@@ -444,16 +547,11 @@ void BPLUSTREE_TYPE::AdjustLeafNode(LeafPage *leaf_node, const KeyType &key, Tra
       leaf_node->MoveAllTo(left_neigh_node);
       left_neigh_node->SetNextPageId(leaf_node->GetNextPageId());
       parent_node->Remove(index);
-      transaction->AddIntoDeletedPageSet(leaf_node->GetPageId());
+      deleted_pages->push_back(leaf_node->GetPageId());
     }
-
-    left_neigh_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(left_neigh_page->GetPageId(), true);
-
   } else if (index + 1 < parent_node->GetSize()) {
-    Page *right_neigh_page = buffer_pool_manager_->FetchPage(parent_node->ValueAt(index + 1));
-    right_neigh_page->WLatch();
-    auto right_neigh_node = reinterpret_cast<LeafPage *>(right_neigh_page->GetData());
+    WritePageGuard right_neigh_guard = buffer_pool_manager_->FetchPageWrite(parent_node->ValueAt(index + 1));
+    auto right_neigh_node = right_neigh_guard.AsMut<LeafPage>();
 
     if (right_neigh_node->GetSize() > right_neigh_node->GetMinSize()) {
       right_neigh_node->MoveFirstToEndOf(leaf_node);
@@ -462,47 +560,40 @@ void BPLUSTREE_TYPE::AdjustLeafNode(LeafPage *leaf_node, const KeyType &key, Tra
       right_neigh_node->MoveAllTo(leaf_node);
       leaf_node->SetNextPageId(right_neigh_node->GetNextPageId());
       parent_node->Remove(index + 1);
-      transaction->AddIntoDeletedPageSet(right_neigh_node->GetPageId());
+      deleted_pages->push_back(right_neigh_node->GetPageId());
     }
-
-    right_neigh_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(right_neigh_page->GetPageId(), true);
   }
 
   if (parent_node->GetSize() < parent_node->GetMinSize()) {
-    AdjustInternalNode(parent_node, key, transaction);
+    AdjustInternalNode(parent_node, key, deleted_pages);
   }
-
-  buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::AdjustInternalNode(InternalPage *internal_node, const KeyType &key, Transaction *transaction) {
+void BPLUSTREE_TYPE::AdjustInternalNode(InternalPage *internal_node, const KeyType &key,
+                                        std::vector<page_id_t> *deleted_pages) {
   if (internal_node->IsRootPage()) {
     if (internal_node->GetSize() == 1) {
       page_id_t child_page_id = internal_node->RemoveAndReturnOnlyChild();
-      Page *child_page = buffer_pool_manager_->FetchPage(child_page_id);
-      auto child_node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
-      child_node->SetParentPageId(INVALID_PAGE_ID);
-      buffer_pool_manager_->UnpinPage(child_page->GetPageId(), true);
+      buffer_pool_manager_->FetchPageBasic(child_page_id).AsMut<BPlusTreePage>()->SetParentPageId(INVALID_PAGE_ID);
 
       root_page_id_ = child_page_id;
       UpdateRootPageId(0);
 
-      transaction->AddIntoDeletedPageSet(internal_node->GetPageId());
+      deleted_pages->push_back(internal_node->GetPageId());
     }
 
     return;
   }
 
-  Page *parent_page = buffer_pool_manager_->FetchPage(internal_node->GetParentPageId());
-  auto parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  // The parent is already write-latched by the caller, which still holds it among its ancestors.
+  BasicPageGuard parent_guard = buffer_pool_manager_->FetchPageBasic(internal_node->GetParentPageId());
+  auto parent_node = parent_guard.AsMut<InternalPage>();
   int index = parent_node->KeyIndex(key, comparator_);
 
   if (index - 1 >= 0) {
-    Page *left_neigh_page = buffer_pool_manager_->FetchPage(parent_node->ValueAt(index - 1));
-    left_neigh_page->WLatch();
-    auto left_neigh_node = reinterpret_cast<InternalPage *>(left_neigh_page->GetData());
+    WritePageGuard left_neigh_guard = buffer_pool_manager_->FetchPageWrite(parent_node->ValueAt(index - 1));
+    auto left_neigh_node = left_neigh_guard.AsMut<InternalPage>();
 
     if (left_neigh_node->GetSize() > left_neigh_node->GetMinSize()) {
       left_neigh_node->MoveLastToFrontOf(internal_node, parent_node->KeyAt(index), buffer_pool_manager_);
@@ -510,16 +601,11 @@ void BPLUSTREE_TYPE::AdjustInternalNode(InternalPage *internal_node, const KeyTy
     } else {
       internal_node->MoveAllTo(left_neigh_node, parent_node->KeyAt(index), buffer_pool_manager_);
       parent_node->Remove(index);
-      transaction->AddIntoDeletedPageSet(internal_node->GetPageId());
+      deleted_pages->push_back(internal_node->GetPageId());
     }
-
-    left_neigh_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(left_neigh_page->GetPageId(), true);
-
   } else if (index + 1 < parent_node->GetSize()) {
-    Page *right_neigh_page = buffer_pool_manager_->FetchPage(parent_node->ValueAt(index + 1));
-    right_neigh_page->WLatch();
-    auto right_neigh_node = reinterpret_cast<InternalPage *>(right_neigh_page->GetData());
+    WritePageGuard right_neigh_guard = buffer_pool_manager_->FetchPageWrite(parent_node->ValueAt(index + 1));
+    auto right_neigh_node = right_neigh_guard.AsMut<InternalPage>();
 
     if (right_neigh_node->GetSize() > right_neigh_node->GetMinSize()) {
       right_neigh_node->MoveFirstToEndOf(internal_node, parent_node->KeyAt(index + 1), buffer_pool_manager_);
@@ -527,18 +613,13 @@ void BPLUSTREE_TYPE::AdjustInternalNode(InternalPage *internal_node, const KeyTy
     } else {
       right_neigh_node->MoveAllTo(internal_node, parent_node->KeyAt(index + 1), buffer_pool_manager_);
       parent_node->Remove(index + 1);
-      transaction->AddIntoDeletedPageSet(right_neigh_node->GetPageId());
+      deleted_pages->push_back(right_neigh_node->GetPageId());
     }
-
-    right_neigh_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(right_neigh_page->GetPageId(), true);
   }
 
   if (parent_node->GetSize() < parent_node->GetMinSize()) {
-    AdjustInternalNode(parent_node, key, transaction);
+    AdjustInternalNode(parent_node, key, deleted_pages);
   }
-
-  buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
 }
 /*
  * Move all the key & value pairs from one page to its sibling page, and notify
@@ -595,10 +676,8 @@ auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool { return f
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
-  rwlatch_.RLock();
-  Page *page = FindLeafPage(KeyType(), 1);
-  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, 0);
+auto BPLUSTREE_TYPE::Begin(BufferAccessStrategy *strategy) -> INDEXITERATOR_TYPE {
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, FindLeafPage(KeyType(), 1), 0, strategy);
 }
 
 /*
@@ -607,11 +686,10 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
-  rwlatch_.RLock();
-  Page *page = FindLeafPage(key);
-  int index = reinterpret_cast<LeafPage *>(page->GetData())->KeyIndex(key, comparator_);
-  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, index);
+auto BPLUSTREE_TYPE::Begin(const KeyType &key, BufferAccessStrategy *strategy) -> INDEXITERATOR_TYPE {
+  ReadPageGuard guard = FindLeafPage(key);
+  int index = guard.IsValid() ? guard.As<LeafPage>()->KeyIndex(key, comparator_) : 0;
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, std::move(guard), index, strategy);
 }
 
 /*
@@ -621,10 +699,9 @@ auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE {
-  rwlatch_.RLock();
-  Page *page = FindLeafPage(KeyType(), 2);
-  int index = reinterpret_cast<LeafPage *>(page->GetData())->GetSize();
-  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, index);
+  ReadPageGuard guard = FindLeafPage(KeyType(), 2);
+  int index = guard.IsValid() ? guard.As<LeafPage>()->GetSize() : 0;
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, std::move(guard), index);
 }
 
 /*****************************************************************************
@@ -635,17 +712,26 @@ auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE {
  * the left most leaf page
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, int option) -> Page * {
+auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, int option) -> ReadPageGuard {
   // throw Exception(ExceptionType::NOT_IMPLEMENTED, "Implement this for test");
-  page_id_t page_id = root_page_id_;
-  Page *page = buffer_pool_manager_->FetchPage(page_id);
-  page->RLatch();
-  rwlatch_.RUnlock();
+  ReadPageGuard guard;
+  while (true) {
+    page_id_t root_page_id = root_page_id_.load();
+    if (root_page_id == INVALID_PAGE_ID) {
+      return guard;
+    }
+    guard = buffer_pool_manager_->FetchPageRead(root_page_id);
+    // The root may have been split or emptied before the latch was taken. Once latched, it stays the root.
+    if (root_page_id_.load() == root_page_id) {
+      break;
+    }
+  }
 
-  auto *curr_node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  auto *curr_node = guard.As<BPlusTreePage>();
 
   while (!curr_node->IsLeafPage()) {
-    auto *node = reinterpret_cast<InternalPage *>(page->GetData());
+    auto *node = guard.As<InternalPage>();
+    page_id_t page_id = INVALID_PAGE_ID;
     if (option == 0) {
       page_id = node->Lookup(key, comparator_);
     } else if (option == 1) {
@@ -654,17 +740,130 @@ auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, int option) -> Page * {
       page_id = node->ValueAt(node->GetSize() - 1);
     }
 
-    Page *child_page = buffer_pool_manager_->FetchPage(page_id);
-    child_page->RLatch();
+    // The child is latched before the parent is released.
+    ReadPageGuard child_guard = buffer_pool_manager_->FetchPageRead(page_id);
+    guard = std::move(child_guard);
+    curr_node = guard.As<BPlusTreePage>();
+  }
 
-    page->RUnlatch();
-    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return guard;
+}
 
-    page = child_page;
-    curr_node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+/*
+ * Find the leaf page containing key, read-latching the internal pages on the
+ * way down and write-latching only the leaf.
+ * @return : the write-latched leaf page, an empty guard if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPageForWrite(const KeyType &key) -> WritePageGuard {
+  if (enable_optimistic_lock_coupling) {
+    while (!IsEmpty()) {
+      uint64_t version;
+      WritePageGuard leaf_guard = FindLeafPageOptimistic(key, &version).UpgradeWrite();
+      // The leaf may have been split or merged between its optimistic read and the latch.
+      if (leaf_guard.IsValid() && leaf_guard.GetPage()->ValidateVersionLatched(version)) {
+        return leaf_guard;
+      }
+    }
+    return {};
+  }
+
+  ReadPageGuard parent_guard;
+  while (true) {
+    page_id_t root_page_id = root_page_id_.load();
+    if (root_page_id == INVALID_PAGE_ID) {
+      return {};
+    }
+
+    // Whether to latch the root for reading or writing depends on its type, which can only be checked once latched.
+    BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(root_page_id);
+    if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+      WritePageGuard leaf_guard = guard.UpgradeWrite();
+      if (root_page_id_.load() == root_page_id && leaf_guard.As<BPlusTreePage>()->IsLeafPage()) {
+        return leaf_guard;
+      }
+      continue;
+    }
+
+    parent_guard = guard.UpgradeRead();
+    if (root_page_id_.load() == root_page_id && !parent_guard.As<BPlusTreePage>()->IsLeafPage()) {
+      break;
+    }
+  }
+
+  while (true) {
+    page_id_t page_id = parent_guard.As<InternalPage>()->Lookup(key, comparator_);
+    BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(page_id);
+    // The read latch of the parent keeps the child in the tree, and the type of a node never changes while it is.
+    if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+      return guard.UpgradeWrite();
+    }
+    parent_guard = guard.UpgradeRead();
+  }
+}
+
+/*
+ * Find the leaf page containing key with optimistic lock coupling: pages are
+ * only pinned, and every internal page is validated against its version once
+ * the child it points to has been pinned.
+ * @parameter: version      set to the version of the leaf page, which is
+ * not validated yet
+ * @return : the pinned leaf page, an empty guard if the tree is empty or a
+ * writer got in the way
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key, uint64_t *version) -> BasicPageGuard {
+  page_id_t root_page_id = root_page_id_.load();
+  if (root_page_id == INVALID_PAGE_ID) {
+    return {};
+  }
+  BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(root_page_id);
+  *version = guard.GetPage()->ReadVersion();
+  // The root only changes while the old root is write-latched, so this fails or the validation below does.
+  if (root_page_id_.load() != root_page_id) {
+    return {};
+  }
+
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+    auto *node = guard.As<InternalPage>();
+    // The size may be torn by a writer, so don't search the page beyond its array.
+    if (node->GetSize() < 0 || node->GetSize() > static_cast<int>(INTERNAL_PAGE_SIZE)) {
+      return {};
+    }
+    page_id_t page_id = node->Lookup(key, comparator_);
+    if (!guard.GetPage()->ValidateVersion(*version)) {
+      return {};
+    }
+
+    BasicPageGuard child_guard = buffer_pool_manager_->FetchPageBasic(page_id);
+    uint64_t child_version = child_guard.GetPage()->ReadVersion();
+    // The child may have been unlinked and deleted before it was pinned.
+    if (!guard.GetPage()->ValidateVersion(*version)) {
+      return {};
+    }
+    guard = std::move(child_guard);
+    *version = child_version;
   }
 
-  return page;
+  return guard;
+}
+
+/*
+ * Write-latch the root page, making sure it is still the root once latched.
+ * @return : the write-latched root page, an empty guard if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::LatchRootForWrite() -> WritePageGuard {
+  while (true) {
+    page_id_t root_page_id = root_page_id_.load();
+    if (root_page_id == INVALID_PAGE_ID) {
+      return {};
+    }
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(root_page_id);
+    if (root_page_id_.load() == root_page_id) {
+      return guard;
+    }
+  }
 }
 
 /*
@@ -677,7 +876,10 @@ auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, int option) -> Page * {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  // Root changes of different subtrees, or of other indexes, may update the header page concurrently.
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+  auto *header_page = static_cast<HeaderPage *>(guard.GetPage());
+  guard.SetDirty();
   if (insert_record != 0) {
     // create a new record<index_name + root_page_id> in header_page
     header_page->InsertRecord(index_name_, root_page_id_);
@@ -685,7 +887,6 @@ void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
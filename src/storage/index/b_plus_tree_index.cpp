@@ -11,6 +11,8 @@
 
 #include "storage/index/b_plus_tree_index.h"
 
+#include "common/config.h"
+
 namespace bustub {
 /*
  * Constructor
@@ -18,23 +20,43 @@ namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager)
     : Index(std::move(metadata)),
-      comparator_(GetMetadata()->GetKeySchema()),
+      comparator_(GetMetadata()->GetKeySchema(),
+                  enable_normalized_keys && KeyType::CanNormalize(GetMetadata()->GetKeySchema())),
       container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, comparator_);
 
   container_.Insert(index_key, rid, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::BulkLoad(std::vector<std::pair<Tuple, RID>> *entries, Transaction *transaction) {
+  // construct index keys
+  std::vector<std::pair<KeyType, RID>> index_entries;
+  index_entries.reserve(entries->size());
+  for (const auto &[key, rid] : *entries) {
+    KeyType index_key;
+    index_key.SetFromKey(key, comparator_);
+    index_entries.emplace_back(index_key, rid);
+  }
+
+  // only an empty tree can be built bottom-up
+  if (!container_.BulkLoad(&index_entries)) {
+    for (const auto &[index_key, rid] : index_entries) {
+      container_.Insert(index_key, rid, transaction);
+    }
+  }
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, comparator_);
 
   container_.Remove(index_key, transaction);
 }
@@ -43,16 +65,20 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, comparator_);
 
   container_.GetValue(index_key, result, transaction);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_INDEX_TYPE::GetBeginIterator() -> INDEXITERATOR_TYPE { return container_.Begin(); }
+auto BPLUSTREE_INDEX_TYPE::GetBeginIterator(BufferAccessStrategy *strategy) -> INDEXITERATOR_TYPE {
+  return container_.Begin(strategy);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE { return container_.Begin(key); }
+auto BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &key, BufferAccessStrategy *strategy) -> INDEXITERATOR_TYPE {
+  return container_.Begin(key, strategy);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetEndIterator() -> INDEXITERATOR_TYPE { return container_.End(); }
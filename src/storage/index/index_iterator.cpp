@@ -2,6 +2,7 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <utility>
 
 #include "storage/index/index_iterator.h"
 
@@ -12,21 +13,16 @@ namespace bustub {
  * set your own input parameters
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index)
-    : buffer_pool_manager_(buffer_pool_manager), page_(page), index_(index) {
-  node_ = reinterpret_cast<LeafPage *>(page_->GetData());
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() {  // NOLINT
-  page_->RUnlatch();
-  buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *buffer_pool_manager, ReadPageGuard guard, int index,
+                                  BufferAccessStrategy *strategy)
+    : buffer_pool_manager_(buffer_pool_manager), guard_(std::move(guard)), index_(index), strategy_(strategy) {
+  node_ = guard_.IsValid() ? guard_.As<LeafPage>() : nullptr;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::IsEnd() -> bool {
   // throw std::runtime_error("unimplemented");
-  return node_->GetNextPageId() == INVALID_PAGE_ID && index_ >= node_->GetSize();
+  return node_ == nullptr || (node_->GetNextPageId() == INVALID_PAGE_ID && index_ >= node_->GetSize());
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -42,13 +38,9 @@ auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
   if (index_ == node_->GetSize() && node_->GetNextPageId() != INVALID_PAGE_ID) {
     page_id_t next_page_id = node_->GetNextPageId();
 
-    page_->RUnlatch();
-    buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
-
-    page_ = buffer_pool_manager_->FetchPage(next_page_id);
-    page_->RLatch();
-
-    node_ = reinterpret_cast<LeafPage *>(page_->GetData());
+    guard_.Drop();
+    guard_ = buffer_pool_manager_->FetchPageRead(next_page_id, strategy_);
+    node_ = guard_.As<LeafPage>();
     index_ = 0;
   }
 
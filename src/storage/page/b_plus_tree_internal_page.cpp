@@ -158,10 +158,8 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, Buf
   int end = GetSize();
   for (int i = 0; i < size; ++i) {
     array_[end + i] = items[i];
-    Page *child_page = buffer_pool_manager->FetchPage(ValueAt(end + i));
-    auto *child_node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
-    child_node->SetParentPageId(GetPageId());
-    buffer_pool_manager->UnpinPage(child_page->GetPageId(), true);
+    BasicPageGuard child_guard = buffer_pool_manager->FetchPageBasic(ValueAt(end + i));
+    child_guard.AsMut<BPlusTreePage>()->SetParentPageId(GetPageId());
   }
   IncreaseSize(size);
 }
@@ -238,10 +236,8 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, Buffe
   array_[GetSize()] = pair;
   IncreaseSize(1);
 
-  Page *child_page = buffer_pool_manager->FetchPage(ValueAt(GetSize() - 1));
-  auto *child_node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
-  child_node->SetParentPageId(GetPageId());
-  buffer_pool_manager->UnpinPage(child_page->GetPageId(), true);
+  BasicPageGuard child_guard = buffer_pool_manager->FetchPageBasic(ValueAt(GetSize() - 1));
+  child_guard.AsMut<BPlusTreePage>()->SetParentPageId(GetPageId());
 }
 
 /*
@@ -271,10 +267,8 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair, Buff
   IncreaseSize(1);
   array_[0] = pair;
 
-  Page *child_page = buffer_pool_manager->FetchPage(ValueAt(0));
-  auto *child_node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
-  child_node->SetParentPageId(GetPageId());
-  buffer_pool_manager->UnpinPage(child_page->GetPageId(), true);
+  BasicPageGuard child_guard = buffer_pool_manager->FetchPageBasic(ValueAt(0));
+  child_guard.AsMut<BPlusTreePage>()->SetParentPageId(GetPageId());
 }
 
 // valuetype for internalNode should be page id_t
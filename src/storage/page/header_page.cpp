@@ -14,6 +14,8 @@
 
 #include "storage/page/header_page.h"
 
+#include "common/exception.h"
+
 namespace bustub {
 
 /**
@@ -29,6 +31,10 @@ auto HeaderPage::InsertRecord(const std::string &name, const page_id_t root_id)
   if (FindRecord(name) != -1) {
     return false;
   }
+  // the record must not run into the page size
+  if (offset + 36 > static_cast<int>(OFFSET_PAGE_SIZE)) {
+    return false;
+  }
   // copy record content
   memcpy(GetData() + offset, name.c_str(), (name.length() + 1));
   memcpy((GetData() + offset + 32), &root_id, 4);
@@ -90,6 +96,22 @@ auto HeaderPage::GetRecordCount() -> int { return *reinterpret_cast<int *>(GetDa
 
 void HeaderPage::SetRecordCount(int record_count) { memcpy(GetData(), &record_count, 4); }
 
+// page size
+auto HeaderPage::GetPageSize() -> int { return *reinterpret_cast<int *>(GetData() + OFFSET_PAGE_SIZE); }
+
+void HeaderPage::SetPageSize(int page_size) { memcpy(GetData() + OFFSET_PAGE_SIZE, &page_size, 4); }
+
+void HeaderPage::CheckPageSize() {
+  int page_size = GetPageSize();
+  if (page_size == 0) {
+    SetPageSize(PAGE_SIZE);
+  } else if (page_size != PAGE_SIZE) {
+    throw Exception(ExceptionType::INCOMPATIBLE_FILE, "database file uses " + std::to_string(page_size) +
+                                                          " byte pages, but this build uses " +
+                                                          std::to_string(PAGE_SIZE) + " byte pages");
+  }
+}
+
 auto HeaderPage::FindRecord(const std::string &name) -> int {
   int record_num = GetRecordCount();
 
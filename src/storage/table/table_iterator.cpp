@@ -10,14 +10,16 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <utility>
 
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn), strategy_(strategy) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
@@ -35,19 +37,19 @@ auto TableIterator::operator->() -> Tuple * {
 
 auto TableIterator::operator++() -> TableIterator & {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr);  // all pages are pinned
+  ReadPageGuard guard = buffer_pool_manager->FetchPageRead(tuple_->rid_.GetPageId(), strategy_);
+  assert(guard.IsValid());  // all pages are pinned
+  auto cur_page = static_cast<TablePage *>(guard.GetPage());
 
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
+      auto next_page_id = cur_page->GetNextPageId();
+      table_heap_->RecordNextPageId(cur_page->GetTablePageId(), next_page_id);
+      ReadAhead(next_page_id);
+      guard = buffer_pool_manager->FetchPageRead(next_page_id, strategy_);
+      cur_page = static_cast<TablePage *>(guard.GetPage());
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
@@ -56,11 +58,10 @@ auto TableIterator::operator++() -> TableIterator & {
   tuple_->rid_ = next_tuple_rid;
 
   if (*this != table_heap_->End()) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+    // cur_page holds the next tuple and is still latched, so read it from there.
+    cur_page->GetTuple(tuple_->rid_, tuple_, txn_, table_heap_->lock_manager_);
   }
-  // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
+  // the guard releases the page once the tuple is copied
   return *this;
 }
 
@@ -70,4 +71,50 @@ auto TableIterator::operator++(int) -> TableIterator {
   return clone;
 }
 
+void TableIterator::ReadAhead(page_id_t page_id) {
+  if (!enable_readahead) {
+    return;
+  }
+  BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+  // Never let read-ahead hold more than an eighth of the buffer pool.
+  auto max_window = std::min(static_cast<size_t>(READAHEAD_MAX_PAGES), buffer_pool_manager->GetPoolSize() / 8);
+  if (strategy_ != nullptr) {
+    // Pages read ahead must not recycle each other before the scan gets to them.
+    max_window = std::min(max_window, strategy_->GetRingSize()) / 2;
+  }
+  if (max_window == 0) {
+    return;
+  }
+  if (pages_read_ahead_ > 0) {
+    --pages_read_ahead_;
+  }
+  // Only issue the next request once the scan has consumed half of the previous one.
+  if (pages_read_ahead_ > readahead_window_ / 2) {
+    return;
+  }
+  readahead_window_ = readahead_window_ == 0 ? READAHEAD_MIN_PAGES : readahead_window_ * 2;
+  readahead_window_ = std::min(readahead_window_, max_window);
+
+  // Only pages already known to belong to the chain are requested. Guessing ids past the end of the table could
+  // read pages that have not been allocated yet.
+  auto page_ids = table_heap_->GetNextPageIds(page_id, pages_read_ahead_ + readahead_window_);
+  if (page_ids.size() <= pages_read_ahead_) {
+    return;
+  }
+  page_ids.erase(page_ids.begin(), page_ids.begin() + pages_read_ahead_);
+  pages_read_ahead_ += page_ids.size();
+
+  readahead_ticket_ = table_heap_->ReadAheadAsync(std::move(page_ids), strategy_);
+}
+
+void TableIterator::ResetReadAhead() {
+  // The strategy of the requests in flight must outlive them.
+  if (readahead_ticket_ != 0) {
+    table_heap_->WaitForReadAhead(readahead_ticket_);
+    readahead_ticket_ = 0;
+  }
+  readahead_window_ = 0;
+  pages_read_ahead_ = 0;
+}
+
 }  // namespace bustub
@@ -11,18 +11,22 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
 // NOLINTNEXTLINE
 // Check whether pages containing terminal characters can be recovered
 TEST(BufferPoolManagerInstanceTest, BinaryDataTest) {
-  const std::string db_name = "test.db";
+  const std::string db_name = "buffer_pool_manager_instance_test.db";
   const size_t buffer_pool_size = 10;
 
   std::random_device r;
@@ -79,7 +83,8 @@ TEST(BufferPoolManagerInstanceTest, BinaryDataTest) {
 
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
-  remove("test.db");
+  remove("buffer_pool_manager_instance_test.db");
+  remove("buffer_pool_manager_instance_test.crc");
 
   delete bpm;
   delete disk_manager;
@@ -87,7 +92,7 @@ TEST(BufferPoolManagerInstanceTest, BinaryDataTest) {
 
 // NOLINTNEXTLINE
 TEST(BufferPoolManagerInstanceTest, SampleTest) {
-  const std::string db_name = "test.db";
+  const std::string db_name = "buffer_pool_manager_instance_test.db";
   const size_t buffer_pool_size = 10;
 
   auto *disk_manager = new DiskManager(db_name);
@@ -135,7 +140,563 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
 
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
-  remove("test.db");
+  remove("buffer_pool_manager_instance_test.db");
+  remove("buffer_pool_manager_instance_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentFetchTest) {
+  const std::string db_name = "buffer_pool_manager_instance_test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_pages = 20;
+  const int num_threads = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: threads fetching overlapping pages, half of which are resident, always see the right contents.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&bpm, tid] {
+      for (int round = 0; round < 100; ++round) {
+        page_id_t page_id = (tid + round) % num_pages;
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(page_id, std::stoi(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Scenario: batch fetches racing single-page fetches of the same misses load each page once and see its contents.
+  threads.clear();
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&bpm, tid] {
+      for (int round = 0; round < 100; ++round) {
+        std::vector<page_id_t> page_ids{round % num_pages, (round + 1) % num_pages};
+        std::vector<Page *> pages;
+        if (tid % 2 == 0) {
+          pages = bpm->FetchPages(page_ids);
+        } else {
+          pages = {bpm->FetchPage(page_ids[0]), bpm->FetchPage(page_ids[1])};
+        }
+        for (size_t i = 0; i < page_ids.size(); ++i) {
+          if (pages[i] == nullptr) {
+            continue;
+          }
+          EXPECT_EQ(page_ids[i], std::stoi(pages[i]->GetData()));
+          EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Scenario: every frame has been released, so the whole pool can be reused.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  disk_manager->ShutDown();
+  remove("buffer_pool_manager_instance_test.db");
+  remove("buffer_pool_manager_instance_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageCleanerTest) {
+  const std::string db_name = "buffer_pool_manager_instance_test.db";
+  const size_t buffer_pool_size = 10;
+
+  ScopedSetting page_cleaner(&enable_page_cleaner, true);
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  std::vector<Page *> pages;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+    pages.push_back(page);
+  }
+  for (auto *page : pages) {
+    EXPECT_EQ(true, bpm->UnpinPage(page->GetPageId(), true));
+  }
+
+  // Scenario: a page cleaner pass writes back dirty unpinned frames.
+  bpm->CleanNow();
+  size_t num_clean = 0;
+  for (auto *page : pages) {
+    num_clean += page->IsDirty() ? 0 : 1;
+  }
+  EXPECT_LE(buffer_pool_size / 4 + 1, num_clean);
+
+  // Scenario: pages evicted after being cleaned still come back with their contents.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  auto *page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "0"));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+
+  disk_manager->ShutDown();
+  remove("buffer_pool_manager_instance_test.db");
+  remove("buffer_pool_manager_instance_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FetchPagesTest) {
+  const std::string db_name = "buffer_pool_manager_instance_test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name, DiskIOBackend::POSIX);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size * 2; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  // The page cleaner pins the dirty pages it writes, so leave it nothing to write while pin counts are checked.
+  bpm->FlushAllPages();
+  bpm->CleanNow();
+
+  // Scenario: a batch mixing resident pages, misses and a duplicate pins every page it returns.
+  std::vector<page_id_t> page_ids{0, 1, 2, 3, 15, 18, 19, 2};
+  auto pages = bpm->FetchPages(page_ids);
+  ASSERT_EQ(page_ids.size(), pages.size());
+  for (size_t i = 0; i < pages.size(); ++i) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(page_ids[i], pages[i]->GetPageId());
+    EXPECT_EQ(page_ids[i], std::stoi(pages[i]->GetData()));
+  }
+  EXPECT_EQ(2, pages[2]->GetPinCount());
+  for (page_id_t page_id : page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: prefetched pages are resident but not pinned.
+  bpm->PrefetchPages({5, 6, 7});
+  for (page_id_t page_id = 5; page_id <= 7; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_EQ(page_id, std::stoi(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("buffer_pool_manager_instance_test.db");
+  remove("buffer_pool_manager_instance_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ScanResistantReplacerTest) {
+  const std::string db_name = "buffer_pool_manager_instance_test.db";
+  const size_t buffer_pool_size = 10;
+  const page_id_t num_hot_pages = 4;
+
+  for (auto replacer_type : {ReplacerType::LRU_K, ReplacerType::TWO_Q}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, replacer_type);
+
+    page_id_t page_id_temp;
+    for (size_t i = 0; i < buffer_pool_size * 4; ++i) {
+      auto *page = bpm->NewPage(&page_id_temp);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+      EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    }
+    bpm->FlushAllPages();
+
+    // Warm up the hot pages with repeated accesses.
+    for (int round = 0; round < 2; ++round) {
+      for (page_id_t page_id = 0; page_id < num_hot_pages; ++page_id) {
+        ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    }
+
+    // Scenario: a scan over all the other pages reads correct data through the pool.
+    for (page_id_t page_id = num_hot_pages; page_id < static_cast<page_id_t>(buffer_pool_size * 4); ++page_id) {
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(page_id, std::stoi(page->GetData()));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+
+    // Scenario: the hot pages survived the scan. Their copies on disk are overwritten, yet fetching them still
+    // returns the contents held in the pool.
+    char stale_data[PAGE_SIZE] = "stale";
+    for (page_id_t page_id = 0; page_id < num_hot_pages; ++page_id) {
+      disk_manager->WritePage(page_id, stale_data);
+    }
+    for (page_id_t page_id = 0; page_id < num_hot_pages; ++page_id) {
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(page_id).c_str()));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+
+    disk_manager->ShutDown();
+    remove("buffer_pool_manager_instance_test.db");
+    remove("buffer_pool_manager_instance_test.crc");
+
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BufferAccessStrategyTest) {
+  const std::string db_name = "buffer_pool_manager_instance_test.db";
+  const size_t buffer_pool_size = 64;
+  const page_id_t num_pages = 256;
+  const page_id_t num_hot_pages = 32;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  bpm->FlushAllPages();
+
+  for (page_id_t page_id = 0; page_id < num_hot_pages; ++page_id) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: a bulk scan over all the other pages reads correct data through its ring.
+  BufferAccessStrategy strategy;
+  for (page_id_t page_id = num_hot_pages; page_id < num_pages; ++page_id) {
+    auto *page = bpm->FetchPageWithStrategy(page_id, &strategy);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, std::stoi(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: the scan only recycled its ring, so the hot pages are still in the pool. Their copies on disk are
+  // overwritten, yet fetching them still returns the contents held in the pool.
+  char stale_data[PAGE_SIZE] = "stale";
+  for (page_id_t page_id = 0; page_id < num_hot_pages; ++page_id) {
+    disk_manager->WritePage(page_id, stale_data);
+  }
+  for (page_id_t page_id = 0; page_id < num_hot_pages; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(page_id).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("buffer_pool_manager_instance_test.db");
+  remove("buffer_pool_manager_instance_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ColdUnpinTest) {
+  const std::string db_name = "buffer_pool_manager_instance_test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  bpm->FlushAllPages();
+
+  // Scenario: with pages 0 and 2 pinned, a bulk scan touches resident page 3 through its strategy. Page 3 keeps its
+  // place: it was unpinned after page 1, so the new page takes the frame of page 1.
+  for (page_id_t page_id : {0, 2}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+  }
+  BufferAccessStrategy strategy;
+  ASSERT_NE(nullptr, bpm->FetchPageWithStrategy(3, &strategy));
+  EXPECT_EQ(true, bpm->UnpinPage(3, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  for (page_id_t page_id : {0, 2}) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  char stale_data[PAGE_SIZE] = "stale";
+  disk_manager->WritePage(3, stale_data);
+  auto *page = bpm->FetchPage(3);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("3", page->GetData());
+  EXPECT_EQ(true, bpm->UnpinPage(3, false));
+
+  disk_manager->ShutDown();
+  remove("buffer_pool_manager_instance_test.db");
+  remove("buffer_pool_manager_instance_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, StatsTest) {
+  const std::string db_name = "buffer_pool_manager_instance_test.db";
+  const size_t buffer_pool_size = 4;
+
+  // The page cleaner would take write-backs away from eviction, so keep it out of the counts.
+  ScopedSetting page_cleaner(&enable_page_cleaner, false);
+  ScopedSetting stats_logging(&enable_buffer_pool_stats_logging, true);
+  ScopedSetting stats_interval(&buffer_pool_stats_interval, std::chrono::milliseconds(10));
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: resident pages are hits.
+  for (page_id_t page_id : {0, 1}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+  }
+
+  // Scenario: with pages 0 and 1 pinned, new pages evict dirty pages 2 and 3. Fetching page 2 back is a miss that
+  // evicts another dirty page.
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  for (page_id_t page_id : {0, 1}) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(2));
+  EXPECT_EQ(true, bpm->UnpinPage(2, false));
+
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(2, stats.hits_);
+  EXPECT_EQ(1, stats.misses_);
+  EXPECT_EQ(3, stats.evictions_);
+  EXPECT_EQ(3, stats.dirty_writebacks_);
+  EXPECT_EQ(buffer_pool_size, stats.pinned_frames_high_water_);
+  EXPECT_DOUBLE_EQ(2.0 / 3.0, stats.HitRatio());
+
+  // Scenario: the statistics logger runs in the background and stops with the instance.
+  std::this_thread::sleep_for(buffer_pool_stats_interval * 3);
+
+  disk_manager->ShutDown();
+  remove("buffer_pool_manager_instance_test.db");
+  remove("buffer_pool_manager_instance_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ResizeTest) {
+  const std::string db_name = "buffer_pool_manager_instance_test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t max_pool_size = 8;
+  const int num_pages = 20;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerType::LRU, max_pool_size);
+
+  // Scenario: growing the pool makes room for more pinned pages.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(true, bpm->Resize(max_pool_size));
+  EXPECT_EQ(max_pool_size, bpm->GetPoolSize());
+  for (size_t i = buffer_pool_size; i < max_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(max_pool_size); ++page_id) {
+    snprintf(bpm->FetchPage(page_id)->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: a pinned page in a frame to retire keeps the pool from shrinking, and no other page is evicted.
+  ASSERT_NE(nullptr, bpm->FetchPage(max_pool_size - 1));
+  uint64_t evictions = bpm->GetStats().evictions_;
+  EXPECT_EQ(false, bpm->Resize(2));
+  EXPECT_EQ(max_pool_size, bpm->GetPoolSize());
+  EXPECT_EQ(evictions, bpm->GetStats().evictions_);
+  EXPECT_EQ(true, bpm->UnpinPage(max_pool_size - 1, false));
+
+  // Scenario: shrinking writes back the evicted pages, and only the remaining frames can be pinned.
+  EXPECT_EQ(true, bpm->Resize(2));
+  EXPECT_EQ(2, bpm->GetPoolSize());
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(max_pool_size); ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, std::stoi(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp - 1, false));
+  for (int i = max_pool_size + 2; i < num_pages; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    snprintf(bpm->FetchPage(page_id_temp)->GetData(), PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: the pool is resized back and forth while other threads fetch pages.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 4; ++tid) {
+    threads.emplace_back([&bpm, tid] {
+      for (int round = 0; round < 200; ++round) {
+        page_id_t page_id = (tid * 7 + round) % num_pages;
+        if (page_id == max_pool_size || page_id == max_pool_size + 1) {
+          continue;
+        }
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(page_id, std::stoi(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (int round = 0; round < 50; ++round) {
+    bpm->Resize(round % 2 == 0 ? max_pool_size : 2);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("buffer_pool_manager_instance_test.db");
+  remove("buffer_pool_manager_instance_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageReuseTest) {
+  const std::string db_name = "buffer_pool_manager_instance_test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, 2, 1, disk_manager, nullptr);
+
+  page_id_t page_id_temp;
+  for (page_id_t page_id : {1, 3, 5, 7}) {
+    Page *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+
+  // Scenario: deleted pages are handed out again, lowest id first.
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(9, page_id_temp);
+  EXPECT_EQ(true, bpm->UnpinPage(9, true));
+  EXPECT_EQ(true, bpm->DeletePage(5));
+  EXPECT_EQ(true, bpm->DeletePage(3));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(3, page_id_temp);
+  EXPECT_EQ(true, bpm->UnpinPage(3, true));
+
+  // Scenario: ids that were never handed out are not recorded as free.
+  EXPECT_EQ(true, bpm->DeletePage(101));
+  bpm->FlushAllPages();
+  delete bpm;
+
+  // Scenario: the free-space map and the used ids survive a restart.
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, 2, 1, disk_manager, nullptr);
+  for (page_id_t page_id : {5, 11}) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(page_id, page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: a recycled page that is unpinned clean and evicted reads back empty, not as the deleted page.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  Page *page = bpm->FetchPage(5);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ('\0', page->GetData()[0]);
+  EXPECT_EQ(true, bpm->UnpinPage(5, false));
+
+  // Scenario: a fetch of a deleted page, e.g. through a stale pointer, leaves a copy of it in the pool. Its id is
+  // only handed out again once the copy is evicted, so that the page table never has two pages for one id.
+  EXPECT_EQ(true, bpm->DeletePage(5));
+  ASSERT_NE(nullptr, bpm->FetchPage(5));
+  EXPECT_EQ(true, bpm->UnpinPage(5, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_NE(5, page_id_temp);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  for (page_id_t page_id : {1, 3, 7, 9}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  page = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(5, page_id_temp);
+  EXPECT_EQ('\0', page->GetData()[0]);
+  EXPECT_EQ(true, bpm->UnpinPage(5, false));
+
+  disk_manager->ShutDown();
+  remove("buffer_pool_manager_instance_test.db");
+  remove("buffer_pool_manager_instance_test.crc");
+  remove("buffer_pool_manager_instance_test.fsm");
 
   delete bpm;
   delete disk_manager;
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cstdio>
 #include <thread>  // NOLINT
 #include <vector>
@@ -19,7 +20,7 @@
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -57,6 +58,63 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(6, value);
   clock_replacer.Victim(&value);
   EXPECT_EQ(4, value);
+
+  // Scenario: a cold unpin is the next victim, however recent it is.
+  clock_replacer.Unpin(1);
+  clock_replacer.Unpin(2);
+  clock_replacer.UnpinCold(3);
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+}
+
+TEST(ClockReplacerTest, ConcurrencyTest) {
+  const int num_threads = 8;
+  const int frames_per_thread = 100;
+  ClockReplacer clock_replacer(num_threads * frames_per_thread);
+
+  // Scenario: threads pin and unpin disjoint frames concurrently, leaving every even frame unpinned.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&clock_replacer, tid] {
+      for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < frames_per_thread; ++i) {
+          clock_replacer.Unpin(tid * frames_per_thread + i);
+        }
+        for (int i = 1; i < frames_per_thread; i += 2) {
+          clock_replacer.Pin(tid * frames_per_thread + i);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * frames_per_thread / 2, clock_replacer.Size());
+
+  // Scenario: concurrent victims claim every unpinned frame exactly once.
+  std::vector<std::vector<int>> victims(num_threads);
+  threads.clear();
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&clock_replacer, &victims, tid] {
+      int value;
+      while (clock_replacer.Victim(&value)) {
+        victims[tid].push_back(value);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::vector<int> all_victims;
+  for (const auto &thread_victims : victims) {
+    all_victims.insert(all_victims.end(), thread_victims.begin(), thread_victims.end());
+  }
+  std::sort(all_victims.begin(), all_victims.end());
+  ASSERT_EQ(num_threads * frames_per_thread / 2, all_victims.size());
+  for (size_t i = 0; i < all_victims.size(); ++i) {
+    EXPECT_EQ(static_cast<int>(2 * i), all_victims[i]);
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
 }
 
 }  // namespace bustub
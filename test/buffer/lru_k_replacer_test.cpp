@@ -0,0 +1,144 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Scenario: access six frames, frame 1 twice, and unpin them.
+  for (frame_id_t frame_id : {1, 2, 3, 4, 5, 6, 1}) {
+    lru_k_replacer.RecordAccess(frame_id);
+  }
+  for (frame_id_t frame_id = 1; frame_id <= 6; ++frame_id) {
+    lru_k_replacer.Unpin(frame_id);
+  }
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: frames with a single access go first, oldest access first.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+
+  // Scenario: pinned frames are not victims, a second access moves frame 4 behind frame 5 and 6.
+  lru_k_replacer.Pin(5);
+  lru_k_replacer.RecordAccess(4);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+
+  // Scenario: among frames with two accesses, the older second-to-last access goes first.
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+
+  lru_k_replacer.Unpin(5);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, CorrelatedAccessTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Scenario: back-to-back accesses to frame 1 count as one, so frame 2 with two separate accesses outlives it.
+  for (frame_id_t frame_id : {2, 1, 1, 1, 2}) {
+    lru_k_replacer.RecordAccess(frame_id);
+  }
+  lru_k_replacer.Unpin(1);
+  lru_k_replacer.Unpin(2);
+
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: a frame that was removed starts over without history.
+  lru_k_replacer.Remove(2);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+  lru_k_replacer.RecordAccess(2);
+  lru_k_replacer.RecordAccess(3);
+  lru_k_replacer.RecordAccess(4);
+  lru_k_replacer.RecordAccess(3);
+  for (frame_id_t frame_id = 2; frame_id <= 4; ++frame_id) {
+    lru_k_replacer.Unpin(frame_id);
+  }
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+}
+
+TEST(LRUKReplacerTest, ConcurrencyTest) {
+  const int num_threads = 8;
+  const int frames_per_thread = 50;
+  LRUKReplacer lru_k_replacer(num_threads * frames_per_thread);
+
+  // Scenario: threads access, pin and unpin disjoint frames concurrently, leaving every even frame unpinned.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&lru_k_replacer, tid] {
+      for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < frames_per_thread; ++i) {
+          lru_k_replacer.RecordAccess(tid * frames_per_thread + i);
+          lru_k_replacer.Unpin(tid * frames_per_thread + i);
+        }
+        for (int i = 1; i < frames_per_thread; i += 2) {
+          lru_k_replacer.Pin(tid * frames_per_thread + i);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * frames_per_thread / 2, lru_k_replacer.Size());
+
+  // Scenario: concurrent victims claim every unpinned frame exactly once.
+  std::vector<std::vector<int>> victims(num_threads);
+  threads.clear();
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&lru_k_replacer, &victims, tid] {
+      int value;
+      while (lru_k_replacer.Victim(&value)) {
+        victims[tid].push_back(value);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::vector<int> all_victims;
+  for (const auto &thread_victims : victims) {
+    all_victims.insert(all_victims.end(), thread_victims.begin(), thread_victims.end());
+  }
+  std::sort(all_victims.begin(), all_victims.end());
+  ASSERT_EQ(num_threads * frames_per_thread / 2, all_victims.size());
+  for (size_t i = 0; i < all_victims.size(); ++i) {
+    EXPECT_EQ(static_cast<int>(2 * i), all_victims[i]);
+  }
+}
+
+}  // namespace bustub
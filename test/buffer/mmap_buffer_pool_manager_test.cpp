@@ -0,0 +1,124 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/mmap_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/mmap_buffer_pool_manager.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/page/header_page.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(MmapBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "mmap_buffer_pool_manager_test.db";
+  // enough pages for the Page objects to be created in more than one chunk
+  const int num_pages = 1100;
+
+  // Write a database through a regular buffer pool first.
+  {
+    DiskManager disk_manager(db_name);
+    BufferPoolManagerInstance bpm(4, &disk_manager);
+    page_id_t page_id;
+    auto *header_page = reinterpret_cast<HeaderPage *>(bpm.NewPage(&page_id));
+    header_page->Init();
+    header_page->InsertRecord("foo", 7);
+    bpm.UnpinPage(page_id, true);
+    for (int i = 1; i < num_pages; ++i) {
+      Page *page = bpm.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+      bpm.UnpinPage(page_id, true);
+    }
+    bpm.FlushAllPages();
+    disk_manager.ShutDown();
+  }
+
+  MmapBufferPoolManager bpm(db_name);
+  EXPECT_EQ(num_pages, bpm.GetPoolSize());
+
+  // Scenario: pages are views into the mapping, so fetching a page twice yields the same data without a copy.
+  auto *header_page = reinterpret_cast<HeaderPage *>(bpm.FetchPage(HEADER_PAGE_ID));
+  ASSERT_NE(nullptr, header_page);
+  page_id_t root_id;
+  EXPECT_TRUE(header_page->GetRootId("foo", &root_id));
+  EXPECT_EQ(7, root_id);
+  for (page_id_t page_id = 1; page_id < num_pages; ++page_id) {
+    Page *page = bpm.FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, page->GetPageId());
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(page->GetData(), bpm.FetchPage(page_id)->GetData());
+    EXPECT_TRUE(bpm.UnpinPage(page_id, false));
+    EXPECT_TRUE(bpm.UnpinPage(page_id, false));
+  }
+
+  // Scenario: the buffer pool is read-only, and pages past the end of the file don't exist.
+  EXPECT_EQ(nullptr, bpm.FetchPage(num_pages));
+  EXPECT_FALSE(bpm.UnpinPage(num_pages, false));
+  EXPECT_FALSE(bpm.UnpinPage(1, true));
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm.NewPage(&page_id));
+  EXPECT_EQ(INVALID_PAGE_ID, page_id);
+  EXPECT_FALSE(bpm.DeletePage(1));
+
+  remove("mmap_buffer_pool_manager_test.db");
+  remove("mmap_buffer_pool_manager_test.crc");
+}
+
+// NOLINTNEXTLINE
+TEST(MmapBufferPoolManagerTest, TableHeapScanTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 256};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const int num_tuples = 500;
+
+  auto *transaction = new Transaction(0);
+  auto *lock_manager = new LockManager();
+  page_id_t first_page_id;
+  {
+    DiskManager disk_manager("mmap_buffer_pool_manager_test.db");
+    BufferPoolManagerInstance bpm(16, &disk_manager);
+    TableHeap table(&bpm, lock_manager, nullptr, transaction);
+    for (int i = 0; i < num_tuples; ++i) {
+      Tuple tuple{{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(200, 'x'))}, &schema};
+      RID rid;
+      ASSERT_TRUE(table.InsertTuple(tuple, &rid, transaction));
+    }
+    first_page_id = table.GetFirstPageId();
+    bpm.FlushAllPages();
+    disk_manager.ShutDown();
+  }
+
+  // Scenario: a table heap reads the database file through the mapping like through any other buffer pool.
+  MmapBufferPoolManager bpm("mmap_buffer_pool_manager_test.db");
+  TableHeap table(&bpm, lock_manager, nullptr, first_page_id);
+  int i = 0;
+  for (auto itr = table.Begin(transaction); itr != table.End(); ++itr, ++i) {
+    ASSERT_LT(i, num_tuples);
+    EXPECT_EQ(i, itr->GetValue(&schema, 0).GetAs<int32_t>());
+  }
+  EXPECT_EQ(num_tuples, i);
+
+  remove("mmap_buffer_pool_manager_test.db");
+  remove("mmap_buffer_pool_manager_test.log");
+  remove("mmap_buffer_pool_manager_test.crc");
+  delete lock_manager;
+  delete transaction;
+}
+
+}  // namespace bustub
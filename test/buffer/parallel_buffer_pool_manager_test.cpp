@@ -11,18 +11,23 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/parallel_buffer_pool_manager.h"
+#include <algorithm>
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
+#include "common/util/numa_util.h"
 #include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
 // NOLINTNEXTLINE
 // Check whether pages containing terminal characters can be recovered
 TEST(ParallelBufferPoolManagerTest, BinaryDataTest) {
-  const std::string db_name = "test.db";
+  const std::string db_name = "parallel_buffer_pool_manager_test.db";
   const size_t buffer_pool_size = 10;
   const size_t num_instances = 5;
 
@@ -81,7 +86,8 @@ TEST(ParallelBufferPoolManagerTest, BinaryDataTest) {
 
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
-  remove("test.db");
+  remove("parallel_buffer_pool_manager_test.db");
+  remove("parallel_buffer_pool_manager_test.crc");
 
   delete bpm;
   delete disk_manager;
@@ -89,7 +95,7 @@ TEST(ParallelBufferPoolManagerTest, BinaryDataTest) {
 
 // NOLINTNEXTLINE
 TEST(ParallelBufferPoolManagerTest, SampleTest) {
-  const std::string db_name = "test.db";
+  const std::string db_name = "parallel_buffer_pool_manager_test.db";
   const size_t buffer_pool_size = 10;
   const size_t num_instances = 5;
 
@@ -145,7 +151,291 @@ TEST(ParallelBufferPoolManagerTest, SampleTest) {
 
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
-  remove("test.db");
+  remove("parallel_buffer_pool_manager_test.db");
+  remove("parallel_buffer_pool_manager_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, FetchPagesTest) {
+  const std::string db_name = "parallel_buffer_pool_manager_test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t num_instances = 3;
+  const int num_pages = 24;
+
+  auto *disk_manager = new DiskManager(db_name, DiskIOBackend::POSIX);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: a batch spanning every instance comes back in request order.
+  std::vector<page_id_t> page_ids{7, 0, 1, 2, 3, 4, 5};
+  auto pages = bpm->FetchPages(page_ids);
+  ASSERT_EQ(page_ids.size(), pages.size());
+  for (size_t i = 0; i < pages.size(); ++i) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(page_ids[i], std::stoi(pages[i]->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+  }
+
+  disk_manager->ShutDown();
+  remove("parallel_buffer_pool_manager_test.db");
+  remove("parallel_buffer_pool_manager_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, NewPageSkipsPinnedInstancesTest) {
+  const std::string db_name = "parallel_buffer_pool_manager_test.db";
+  const size_t buffer_pool_size = 2;
+  const size_t num_instances = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: pin every frame of every instance.
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size * num_instances; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    page_ids.push_back(page_id_temp);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  // Scenario: only the last instance has unpinned frames, so every new page has to come from it.
+  for (page_id_t page_id : page_ids) {
+    if (page_id % num_instances == num_instances - 1) {
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    }
+  }
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(num_instances - 1, page_id_temp % num_instances);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  disk_manager->ShutDown();
+  remove("parallel_buffer_pool_manager_test.db");
+  remove("parallel_buffer_pool_manager_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, NumaPlacementTest) {
+  const std::string db_name = "parallel_buffer_pool_manager_test.db";
+  const size_t buffer_pool_size = 8;
+  const size_t num_instances = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  ScopedSetting numa_placement(&enable_numa_placement, true);
+
+  // Scenario: instances are spread round robin over the NUMA nodes, and their pages don't share cache lines.
+  for (uint32_t i = 0; i < num_instances; ++i) {
+    BufferPoolManagerInstance instance(buffer_pool_size, num_instances, i, disk_manager);
+    const std::vector<int> &nodes = NumaUtil::GetOnlineNodes();
+    EXPECT_EQ(nodes[i % nodes.size()], instance.GetNumaNode());
+    for (size_t j = 0; j < buffer_pool_size; ++j) {
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(&instance.GetPages()[j]) % CACHE_LINE_SIZE);
+    }
+  }
+
+  // Scenario: with placement enabled, every frame of every instance can still be handed out and read back.
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size * num_instances; ++i) {
+    Page *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    page_ids.push_back(page_id_temp);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  for (page_id_t page_id : page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  for (page_id_t page_id : page_ids) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("parallel_buffer_pool_manager_test.db");
+  remove("parallel_buffer_pool_manager_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrentNewPageTest) {
+  const std::string db_name = "parallel_buffer_pool_manager_test.db";
+  const size_t buffer_pool_size = 16;
+  const size_t num_instances = 4;
+  const int num_threads = 4;
+  const int pages_per_thread = 1000;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: threads create and unpin pages concurrently, and every page gets a distinct id.
+  std::vector<std::vector<page_id_t>> page_ids(num_threads);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([bpm, &page_ids, tid] {
+      for (int i = 0; i < pages_per_thread; ++i) {
+        page_id_t page_id;
+        auto *page = bpm->NewPage(&page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+        page_ids[tid].push_back(page_id);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::vector<page_id_t> all_page_ids;
+  for (const auto &thread_page_ids : page_ids) {
+    all_page_ids.insert(all_page_ids.end(), thread_page_ids.begin(), thread_page_ids.end());
+  }
+  std::sort(all_page_ids.begin(), all_page_ids.end());
+  EXPECT_EQ(all_page_ids.end(), std::adjacent_find(all_page_ids.begin(), all_page_ids.end()));
+  ASSERT_EQ(num_threads * pages_per_thread, all_page_ids.size());
+
+  for (page_id_t page_id : {all_page_ids.front(), all_page_ids.back()}) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, std::stoi(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("parallel_buffer_pool_manager_test.db");
+  remove("parallel_buffer_pool_manager_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, FlushAllPagesTest) {
+  const std::string db_name = "parallel_buffer_pool_manager_test.db";
+  const size_t buffer_pool_size = 8;
+  const size_t num_instances = 4;
+  const int num_pages = buffer_pool_size * num_instances;
+
+  // The page cleaner would write pages back on its own.
+  ScopedSetting page_cleaner(&enable_page_cleaner, false);
+  auto *disk_manager = new DiskManager(db_name, DiskIOBackend::POSIX);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  // one page stays pinned, the flush must neither skip it nor unpin it
+  ASSERT_NE(nullptr, bpm->FetchPage(5));
+
+  // Scenario: every dirty page is written exactly once, and the pages are pinned again only by their users.
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_pages, disk_manager->GetNumWrites());
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_pages, disk_manager->GetNumWrites());
+  EXPECT_EQ(true, bpm->UnpinPage(5, false));
+  EXPECT_EQ(false, bpm->UnpinPage(5, false));
+
+  DiskManager reader(db_name, DiskIOBackend::POSIX);
+  char data[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+    reader.ReadPage(page_id, data);
+    EXPECT_EQ(page_id, std::stoi(data));
+  }
+  reader.ShutDown();
+
+  // Scenario: flushed pages are clean, so they are evicted without being written again.
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(num_pages, disk_manager->GetNumWrites());
+
+  // Scenario: a page whose write-back fails is dirty again afterwards.
+  page_id_t page_id;
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  disk_manager->ShutDown();
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  bpm->FlushAllPages();
+  EXPECT_EQ(true, page->IsDirty());
+  remove("parallel_buffer_pool_manager_test.db");
+  remove("parallel_buffer_pool_manager_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "parallel_buffer_pool_manager_test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t max_pool_size = 8;
+  const size_t num_instances = 2;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager, nullptr, ReplacerType::LRU,
+                                            max_pool_size);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size * num_instances; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: when the second instance can't shrink, the first one grows back, and every instance keeps its size.
+  for (page_id_t page_id : page_ids) {
+    if (page_id % num_instances == 1) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    }
+  }
+  EXPECT_EQ(false, bpm->Resize(2));
+  EXPECT_EQ(buffer_pool_size * num_instances, bpm->GetPoolSize());
+  for (page_id_t page_id : page_ids) {
+    if (page_id % num_instances == 1) {
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+  }
+
+  // Scenario: without pinned pages, every instance shrinks and grows.
+  EXPECT_EQ(true, bpm->Resize(2));
+  EXPECT_EQ(2 * num_instances, bpm->GetPoolSize());
+  EXPECT_EQ(true, bpm->Resize(max_pool_size));
+  EXPECT_EQ(max_pool_size * num_instances, bpm->GetPoolSize());
+
+  disk_manager->ShutDown();
+  remove("parallel_buffer_pool_manager_test.db");
+  remove("parallel_buffer_pool_manager_test.crc");
 
   delete bpm;
   delete disk_manager;
@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer_hit_ratio_test.cpp
+//
+// Identification: test/buffer/replacer_hit_ratio_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <list>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/two_q_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+/** A page access of a trace. Only point lookups count towards the hit ratio. */
+struct Access {
+  page_id_t page_id_;
+  bool is_lookup_;
+};
+
+/**
+ * Replays a trace against a buffer pool of pool_size frames managed by replacer. Every access pins the page,
+ * records the access and unpins it again, the way a fetch and unpin through the buffer pool manager does. The trace
+ * is replayed on one thread, so the hit ratios are deterministic.
+ * @return the fraction of point lookups that hit the pool
+ */
+auto LookupHitRatio(Replacer *replacer, size_t pool_size, const std::vector<Access> &trace) -> double {
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::vector<page_id_t> frames(pool_size, INVALID_PAGE_ID);
+  std::list<frame_id_t> free_list;
+  for (size_t i = 0; i < pool_size; ++i) {
+    free_list.emplace_back(static_cast<frame_id_t>(i));
+  }
+
+  size_t lookups = 0;
+  size_t hits = 0;
+  for (const auto &access : trace) {
+    frame_id_t frame_id;
+    auto iter = page_table.find(access.page_id_);
+    if (iter != page_table.end()) {
+      frame_id = iter->second;
+      replacer->Pin(frame_id);
+      hits += access.is_lookup_ ? 1 : 0;
+    } else {
+      if (!free_list.empty()) {
+        frame_id = free_list.front();
+        free_list.pop_front();
+      } else {
+        EXPECT_TRUE(replacer->Victim(&frame_id));
+        replacer->Remove(frame_id);
+        page_table.erase(frames[frame_id]);
+      }
+      page_table[access.page_id_] = frame_id;
+      frames[frame_id] = access.page_id_;
+    }
+    lookups += access.is_lookup_ ? 1 : 0;
+    replacer->RecordAccess(frame_id);
+    replacer->Unpin(frame_id);
+  }
+  return static_cast<double>(hits) / static_cast<double>(lookups);
+}
+
+/**
+ * A trace of point lookups into a hot set of index pages, interleaved with a sequential scan over a much larger
+ * table. The scan reads every tuple of a page, so it accesses each page several times in a row.
+ */
+auto MixedTrace(int hot_pages, int scan_pages, int lookups_per_scan_page, int tuples_per_page) -> std::vector<Access> {
+  std::mt19937 rng(15445);
+  std::uniform_int_distribution<page_id_t> hot_dist(0, hot_pages - 1);
+  std::vector<Access> trace;
+  for (page_id_t scan_page = hot_pages; scan_page < hot_pages + scan_pages; ++scan_page) {
+    for (int i = 0; i < tuples_per_page; ++i) {
+      trace.push_back({scan_page, false});
+    }
+    for (int i = 0; i < lookups_per_scan_page; ++i) {
+      trace.push_back({hot_dist(rng), true});
+    }
+  }
+  return trace;
+}
+
+// NOLINTNEXTLINE
+TEST(ReplacerHitRatioTest, MixedScanLookupTest) {
+  const size_t pool_size = 64;
+  auto trace = MixedTrace(48, 20000, 2, 4);
+
+  LRUReplacer lru_replacer(pool_size);
+  LRUKReplacer lru_k_replacer(pool_size);
+  TwoQReplacer two_q_replacer(pool_size);
+  double lru = LookupHitRatio(&lru_replacer, pool_size, trace);
+  double lru_k = LookupHitRatio(&lru_k_replacer, pool_size, trace);
+  double two_q = LookupHitRatio(&two_q_replacer, pool_size, trace);
+
+  // Scenario: the scan pushes the hot set out of an LRU pool, but not out of an LRU-K or 2Q pool.
+  EXPECT_GT(lru_k, lru + 0.1);
+  EXPECT_GT(two_q, lru + 0.1);
+}
+
+// NOLINTNEXTLINE
+TEST(ReplacerHitRatioTest, LookupOnlyTest) {
+  const size_t pool_size = 64;
+  auto trace = MixedTrace(96, 20000, 4, 0);
+
+  LRUReplacer lru_replacer(pool_size);
+  LRUKReplacer lru_k_replacer(pool_size);
+  TwoQReplacer two_q_replacer(pool_size);
+  ClockReplacer clock_replacer(pool_size);
+  double lru = LookupHitRatio(&lru_replacer, pool_size, trace);
+  double lru_k = LookupHitRatio(&lru_k_replacer, pool_size, trace);
+  double two_q = LookupHitRatio(&two_q_replacer, pool_size, trace);
+  double clock = LookupHitRatio(&clock_replacer, pool_size, trace);
+
+  // Scenario: with uniform lookups over a hot set larger than the pool, no policy falls far behind LRU.
+  EXPECT_GT(lru_k, lru - 0.05);
+  EXPECT_GT(two_q, lru - 0.05);
+  EXPECT_GT(clock, lru - 0.05);
+}
+
+}  // namespace bustub
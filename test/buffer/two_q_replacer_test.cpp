@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer_test.cpp
+//
+// Identification: test/buffer/two_q_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/two_q_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(TwoQReplacerTest, SampleTest) {
+  TwoQReplacer two_q_replacer(8);
+
+  // Scenario: frames 1 and 2 are accessed twice and move to Am, frames 3 to 6 stay in A1.
+  for (frame_id_t frame_id : {1, 2, 3, 1, 4, 2, 5, 6}) {
+    two_q_replacer.RecordAccess(frame_id);
+  }
+  for (frame_id_t frame_id = 1; frame_id <= 6; ++frame_id) {
+    two_q_replacer.Unpin(frame_id);
+  }
+  EXPECT_EQ(6, two_q_replacer.Size());
+
+  // Scenario: A1 holds more than a quarter of the frames, so victims come from A1 in FIFO order.
+  int value;
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+
+  // Scenario: A1 is down to the threshold, so the least recently unpinned frame of Am goes next.
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: pinned frames are not victims. Once Am is empty, A1 is used again.
+  two_q_replacer.Pin(5);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+  EXPECT_FALSE(two_q_replacer.Victim(&value));
+
+  two_q_replacer.Unpin(5);
+  EXPECT_EQ(1, two_q_replacer.Size());
+  two_q_replacer.Remove(5);
+  EXPECT_EQ(0, two_q_replacer.Size());
+}
+
+TEST(TwoQReplacerTest, ConcurrencyTest) {
+  const int num_threads = 8;
+  const int frames_per_thread = 50;
+  TwoQReplacer two_q_replacer(num_threads * frames_per_thread);
+
+  // Scenario: threads access, pin and unpin disjoint frames concurrently, leaving every even frame unpinned.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&two_q_replacer, tid] {
+      for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < frames_per_thread; ++i) {
+          two_q_replacer.RecordAccess(tid * frames_per_thread + i);
+          two_q_replacer.Unpin(tid * frames_per_thread + i);
+        }
+        for (int i = 1; i < frames_per_thread; i += 2) {
+          two_q_replacer.Pin(tid * frames_per_thread + i);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * frames_per_thread / 2, two_q_replacer.Size());
+
+  // Scenario: concurrent victims claim every unpinned frame exactly once.
+  std::vector<std::vector<int>> victims(num_threads);
+  threads.clear();
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&two_q_replacer, &victims, tid] {
+      int value;
+      while (two_q_replacer.Victim(&value)) {
+        victims[tid].push_back(value);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::vector<int> all_victims;
+  for (const auto &thread_victims : victims) {
+    all_victims.insert(all_victims.end(), thread_victims.begin(), thread_victims.end());
+  }
+  std::sort(all_victims.begin(), all_victims.end());
+  ASSERT_EQ(num_threads * frames_per_thread / 2, all_victims.size());
+  for (size_t i = 0; i < all_victims.size(); ++i) {
+    EXPECT_EQ(static_cast<int>(2 * i), all_victims[i]);
+  }
+}
+
+}  // namespace bustub
@@ -54,7 +54,7 @@ class TransactionTest : public ::testing::Test {
   void SetUp() override {
     ::testing::Test::SetUp();
     // For each test, we create a new DiskManager, BufferPoolManager, TransactionManager, and Catalog.
-    disk_manager_ = std::make_unique<DiskManager>("executor_test.db");
+    disk_manager_ = std::make_unique<DiskManager>("transaction_test.db");
     bpm_ = std::make_unique<BufferPoolManagerInstance>(2560, disk_manager_.get());
     page_id_t page_id;
     bpm_->NewPage(&page_id);
@@ -78,7 +78,8 @@ class TransactionTest : public ::testing::Test {
     txn_mgr_->Commit(txn_);
     // Shut down the disk manager and clean up the transaction.
     disk_manager_->ShutDown();
-    remove("executor_test.db");
+    remove("transaction_test.db");
+    remove("transaction_test.crc");
     delete txn_;
   };
 
@@ -24,7 +24,7 @@ namespace bustub {
 
 // NOLINTNEXTLINE
 TEST(HashTablePageTest, DirectoryPageSampleTest) {
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = new DiskManager("hash_table_page_test.db");
   auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
 
   // get a directory page from the BufferPoolManager
@@ -51,14 +51,15 @@ TEST(HashTablePageTest, DirectoryPageSampleTest) {
   // unpin the directory page now that we are done
   bpm->UnpinPage(directory_page_id, true, nullptr);
   disk_manager->ShutDown();
-  remove("test.db");
-  delete disk_manager;
+  remove("hash_table_page_test.db");
+  remove("hash_table_page_test.crc");
   delete bpm;
+  delete disk_manager;
 }
 
 // NOLINTNEXTLINE
 TEST(HashTablePageTest, BucketPageSampleTest) {
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = new DiskManager("hash_table_page_test.db");
   auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
 
   // get a bucket page from the BufferPoolManager
@@ -109,9 +110,10 @@ TEST(HashTablePageTest, BucketPageSampleTest) {
   // unpin the directory page now that we are done
   bpm->UnpinPage(bucket_page_id, true, nullptr);
   disk_manager->ShutDown();
-  remove("test.db");
-  delete disk_manager;
+  remove("hash_table_page_test.db");
+  remove("hash_table_page_test.crc");
   delete bpm;
+  delete disk_manager;
 }
 
 }  // namespace bustub
@@ -25,7 +25,7 @@ namespace bustub {
 
 // NOLINTNEXTLINE
 TEST(HashTableTest, SampleTest) {
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = new DiskManager("hash_table_test.db");
   auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
   ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
 
@@ -112,9 +112,10 @@ TEST(HashTableTest, SampleTest) {
   ht.VerifyIntegrity();
 
   disk_manager->ShutDown();
-  remove("test.db");
-  delete disk_manager;
+  remove("hash_table_test.db");
+  remove("hash_table_test.crc");
   delete bpm;
+  delete disk_manager;
 }
 
 }  // namespace bustub
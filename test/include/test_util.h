@@ -14,6 +14,7 @@
 
 #include <sys/stat.h>
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -28,6 +29,36 @@
 
 namespace bustub {
 
+/**
+ * Sets a global configuration variable for as long as the object lives, and restores its previous value when the
+ * object goes out of scope, so that a test failing halfway doesn't leak the setting into the tests after it.
+ */
+template <class T>
+class ScopedSetting {
+ public:
+  template <class V>
+  ScopedSetting(T *setting, V value) : setting_(setting), saved_(*setting) {
+    *setting_ = value;
+  }
+  ~ScopedSetting() { *setting_ = saved_; }
+
+  ScopedSetting(const ScopedSetting &) = delete;
+  auto operator=(const ScopedSetting &) -> ScopedSetting & = delete;
+
+ private:
+  template <class U>
+  struct Value {
+    using Type = U;
+  };
+  template <class U>
+  struct Value<std::atomic<U>> {
+    using Type = U;
+  };
+
+  T *setting_;
+  typename Value<T>::Type saved_;
+};
+
 auto ParseCreateStatement(const std::string &sql_base) -> std::unique_ptr<Schema> {
   std::string::size_type n;
   std::vector<Column> v{};
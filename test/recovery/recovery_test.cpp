@@ -30,21 +30,23 @@ class RecoveryTest : public ::testing::Test {
  protected:
   // This function is called before every test.
   void SetUp() override {
-    remove("test.db");
-    remove("test.log");
+    remove("recovery_test.db");
+    remove("recovery_test.log");
+    remove("recovery_test.crc");
   }
 
   // This function is called after every test.
   void TearDown() override {
     LOG_INFO("Tearing down the system..");
-    remove("test.db");
-    remove("test.log");
+    remove("recovery_test.db");
+    remove("recovery_test.log");
+    remove("recovery_test.crc");
   };
 };
 
 // NOLINTNEXTLINE
 TEST_F(RecoveryTest, DISABLED_RedoTest) {
-  auto *bustub_instance = new BustubInstance("test.db");
+  auto *bustub_instance = new BustubInstance("recovery_test.db");
 
   ASSERT_FALSE(enable_logging);
   LOG_INFO("Skip system recovering...");
@@ -86,7 +88,7 @@ TEST_F(RecoveryTest, DISABLED_RedoTest) {
   delete bustub_instance;
 
   LOG_INFO("System restart...");
-  bustub_instance = new BustubInstance("test.db");
+  bustub_instance = new BustubInstance("recovery_test.db");
 
   ASSERT_FALSE(enable_logging);
   LOG_INFO("Check if tuple is not in table before recovery");
@@ -133,7 +135,7 @@ TEST_F(RecoveryTest, DISABLED_RedoTest) {
 
 // NOLINTNEXTLINE
 TEST_F(RecoveryTest, DISABLED_UndoTest) {
-  auto *bustub_instance = new BustubInstance("test.db");
+  auto *bustub_instance = new BustubInstance("recovery_test.db");
 
   ASSERT_FALSE(enable_logging);
   LOG_INFO("Skip system recovering...");
@@ -170,7 +172,7 @@ TEST_F(RecoveryTest, DISABLED_UndoTest) {
   delete bustub_instance;
 
   LOG_INFO("System restarted..");
-  bustub_instance = new BustubInstance("test.db");
+  bustub_instance = new BustubInstance("recovery_test.db");
 
   LOG_INFO("Check if tuple exists before recovery");
   Tuple old_tuple;
@@ -212,7 +214,7 @@ TEST_F(RecoveryTest, DISABLED_UndoTest) {
 
 // NOLINTNEXTLINE
 TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
-  auto *bustub_instance = new BustubInstance("test.db");
+  auto *bustub_instance = new BustubInstance("recovery_test.db");
 
   EXPECT_FALSE(enable_logging);
   LOG_INFO("Skip system recovering...");
@@ -10,12 +10,15 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
 #include <thread>  // NOLINT
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include "common/config.h"
 #include "gtest/gtest.h"
 #include "storage/index/b_plus_tree.h"
 #include "test_util.h"  // NOLINT
@@ -105,7 +108,7 @@ TEST(BPlusTreeConcurrentTest, InsertTest1) {
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
 
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = new DiskManager("b_plus_tree_concurrent_test.db");
   BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
@@ -146,17 +149,19 @@ TEST(BPlusTreeConcurrentTest, InsertTest1) {
   EXPECT_EQ(current_key, keys.size() + 1);
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
-  delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  delete disk_manager;
+  remove("b_plus_tree_concurrent_test.db");
+  remove("b_plus_tree_concurrent_test.log");
+  remove("b_plus_tree_concurrent_test.crc");
+  remove("b_plus_tree_concurrent_test.fsm");
 }
 
 TEST(BPlusTreeConcurrentTest, InsertTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = new DiskManager("b_plus_tree_concurrent_test.db");
   BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
@@ -197,10 +202,12 @@ TEST(BPlusTreeConcurrentTest, InsertTest2) {
   EXPECT_EQ(current_key, keys.size() + 1);
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
-  delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  delete disk_manager;
+  remove("b_plus_tree_concurrent_test.db");
+  remove("b_plus_tree_concurrent_test.log");
+  remove("b_plus_tree_concurrent_test.crc");
+  remove("b_plus_tree_concurrent_test.fsm");
 }
 
 TEST(BPlusTreeConcurrentTest, DeleteTest1) {
@@ -208,7 +215,7 @@ TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
 
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = new DiskManager("b_plus_tree_concurrent_test.db");
   BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
@@ -239,10 +246,12 @@ TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   EXPECT_EQ(size, 1);
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
-  delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  delete disk_manager;
+  remove("b_plus_tree_concurrent_test.db");
+  remove("b_plus_tree_concurrent_test.log");
+  remove("b_plus_tree_concurrent_test.crc");
+  remove("b_plus_tree_concurrent_test.fsm");
 }
 
 TEST(BPlusTreeConcurrentTest, DeleteTest2) {
@@ -250,7 +259,7 @@ TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
 
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = new DiskManager("b_plus_tree_concurrent_test.db");
   BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
@@ -282,10 +291,105 @@ TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   EXPECT_EQ(size, 4);
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
   delete disk_manager;
+  remove("b_plus_tree_concurrent_test.db");
+  remove("b_plus_tree_concurrent_test.log");
+  remove("b_plus_tree_concurrent_test.crc");
+  remove("b_plus_tree_concurrent_test.fsm");
+}
+
+// helper function to read keys inserted up front while writers insert around them, and then remove what they inserted
+// if remove_new_keys is set
+void ReadWhileWritingHelper(bool optimistic, bool remove_new_keys) {
+  ScopedSetting optimistic_setting(&enable_optimistic_lock_coupling, optimistic);
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("b_plus_tree_concurrent_test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  // create b+ tree with small nodes, so that pages split, merge and are deleted under the readers
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  std::vector<int64_t> old_keys;
+  std::vector<int64_t> new_keys;
+  for (int64_t key = 1; key <= 1000; key++) {
+    (key % 10 == 0 ? old_keys : new_keys).push_back(key);
+  }
+  InsertHelper(&tree, old_keys);
+
+  const int num_writers = 4;
+  std::atomic<bool> writers_done{false};
+  std::atomic<int> missing{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_writers; i++) {
+    threads.emplace_back([&, i] {
+      InsertHelperSplit(&tree, new_keys, num_writers, i);
+      if (remove_new_keys) {
+        DeleteHelperSplit(&tree, new_keys, num_writers, i);
+      }
+    });
+  }
+  for (int i = 0; i < 2; i++) {
+    threads.emplace_back([&] {
+      std::vector<RID> rids;
+      GenericKey<8> index_key;
+      while (!writers_done) {
+        for (auto key : old_keys) {
+          rids.clear();
+          index_key.SetFromInteger(key);
+          if (!tree.GetValue(index_key, &rids) || rids.size() != 1 || rids[0].GetSlotNum() != key) {
+            missing++;
+          }
+        }
+      }
+    });
+  }
+  for (int i = 0; i < num_writers; i++) {
+    threads[i].join();
+  }
+  writers_done = true;
+  for (size_t i = num_writers; i < threads.size(); i++) {
+    threads[i].join();
+  }
+  EXPECT_EQ(0, missing);
+
+  std::vector<int64_t> expected_keys = old_keys;
+  if (!remove_new_keys) {
+    expected_keys.insert(expected_keys.end(), new_keys.begin(), new_keys.end());
+    std::sort(expected_keys.begin(), expected_keys.end());
+  }
+  size_t size = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    ASSERT_LT(size, expected_keys.size());
+    EXPECT_EQ(expected_keys[size], (*iterator).second.GetSlotNum());
+    size = size + 1;
+  }
+  EXPECT_EQ(expected_keys.size(), size);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  delete disk_manager;
+  remove("b_plus_tree_concurrent_test.db");
+  remove("b_plus_tree_concurrent_test.log");
+  remove("b_plus_tree_concurrent_test.crc");
+  remove("b_plus_tree_concurrent_test.fsm");
+}
+
+TEST(BPlusTreeConcurrentTest, InsertReadTest) {
+  // Scenario: keys inserted up front stay visible to readers while writers split leaves and roots around them.
+  ReadWhileWritingHelper(false, false);
+}
+
+TEST(BPlusTreeConcurrentTest, OptimisticReadWriteTest) {
+  // Scenario: readers that don't latch internal pages still find every key inserted up front while writers insert and
+  // then remove keys all around them.
+  ReadWhileWritingHelper(true, true);
 }
 
 TEST(BPlusTreeConcurrentTest, MixTest) {
@@ -293,7 +397,7 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
 
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = new DiskManager("b_plus_tree_concurrent_test.db");
   BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
@@ -327,10 +431,12 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   EXPECT_EQ(size, 5);
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
-  delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  delete disk_manager;
+  remove("b_plus_tree_concurrent_test.db");
+  remove("b_plus_tree_concurrent_test.log");
+  remove("b_plus_tree_concurrent_test.crc");
+  remove("b_plus_tree_concurrent_test.fsm");
 }
 
 }  // namespace bustub
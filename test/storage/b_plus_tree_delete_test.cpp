@@ -25,7 +25,7 @@ TEST(BPlusTreeTests, DeleteTest1) {
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
 
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = new DiskManager("b_plus_tree_delete_test.db");
   BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
@@ -92,10 +92,12 @@ TEST(BPlusTreeTests, DeleteTest1) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
-  delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  delete disk_manager;
+  remove("b_plus_tree_delete_test.db");
+  remove("b_plus_tree_delete_test.log");
+  remove("b_plus_tree_delete_test.crc");
+  remove("b_plus_tree_delete_test.fsm");
 }
 
 TEST(BPlusTreeTests, DeleteTest2) {
@@ -103,7 +105,7 @@ TEST(BPlusTreeTests, DeleteTest2) {
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
 
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = new DiskManager("b_plus_tree_delete_test.db");
   BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
@@ -170,9 +172,62 @@ TEST(BPlusTreeTests, DeleteTest2) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
+  delete bpm;
   delete disk_manager;
+  remove("b_plus_tree_delete_test.db");
+  remove("b_plus_tree_delete_test.log");
+  remove("b_plus_tree_delete_test.crc");
+  remove("b_plus_tree_delete_test.fsm");
+}
+
+TEST(BPlusTreeTests, DeleteWithoutTransactionTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("b_plus_tree_delete_test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // small nodes, so that removing keys merges leaves and internal pages
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 3);
+  GenericKey<8> index_key;
+  RID rid;
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  const int64_t num_keys = 50;
+  for (int64_t key = 1; key <= num_keys; ++key) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, nullptr);
+  }
+
+  // removing without a transaction must merge and delete pages all the same
+  for (int64_t key = 1; key <= num_keys; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, nullptr);
+  }
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= num_keys; ++key) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 2 == 0, tree.GetValue(index_key, &rids));
+  }
+
+  for (int64_t key = 2; key <= num_keys; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, nullptr);
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  delete disk_manager;
+  remove("b_plus_tree_delete_test.db");
+  remove("b_plus_tree_delete_test.log");
+  remove("b_plus_tree_delete_test.crc");
+  remove("b_plus_tree_delete_test.fsm");
 }
 }  // namespace bustub
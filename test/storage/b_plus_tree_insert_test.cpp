@@ -25,7 +25,7 @@ TEST(BPlusTreeTests, InsertTest1) {
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
 
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = new DiskManager("b_plus_tree_insert_test.db");
   BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 2, 3);
@@ -72,10 +72,12 @@ TEST(BPlusTreeTests, InsertTest1) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
-  delete disk_manager;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  delete disk_manager;
+  remove("b_plus_tree_insert_test.db");
+  remove("b_plus_tree_insert_test.log");
+  remove("b_plus_tree_insert_test.crc");
+  remove("b_plus_tree_insert_test.fsm");
 }
 
 TEST(BPlusTreeTests, InsertTest2) {
@@ -83,7 +85,7 @@ TEST(BPlusTreeTests, InsertTest2) {
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
 
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = new DiskManager("b_plus_tree_insert_test.db");
   BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
@@ -140,9 +142,87 @@ TEST(BPlusTreeTests, InsertTest2) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
+  delete bpm;
   delete disk_manager;
+  remove("b_plus_tree_insert_test.db");
+  remove("b_plus_tree_insert_test.log");
+  remove("b_plus_tree_insert_test.crc");
+  remove("b_plus_tree_insert_test.fsm");
+}
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("b_plus_tree_insert_test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree with small nodes, so that it has several internal levels
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  auto *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // Scenario: unsorted input is sorted first, and only the first value of a duplicate key is kept.
+  const int64_t num_keys = 1000;
+  std::vector<std::pair<GenericKey<8>, RID>> entries;
+  for (int64_t key = num_keys; key >= 1; key--) {
+    index_key.SetFromInteger(key);
+    entries.emplace_back(index_key, RID(0, key));
+  }
+  index_key.SetFromInteger(500);
+  entries.emplace_back(index_key, RID(1, 500));
+  EXPECT_TRUE(tree.BulkLoad(&entries, 0.7));
+  EXPECT_EQ(num_keys, entries.size());
+
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= num_keys; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+    ASSERT_EQ(1, rids.size());
+    EXPECT_EQ(RID(0, key), rids[0]);
+  }
+
+  int64_t current_key = 1;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(num_keys + 1, current_key);
+
+  // Scenario: only an empty tree can be bulk loaded.
+  EXPECT_FALSE(tree.BulkLoad(&entries));
+
+  // Scenario: the loaded tree splits and merges like any other, since its parent links and sizes are consistent.
+  for (int64_t key = num_keys + 1; key <= 2 * num_keys; key++) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, RID(0, key), transaction));
+  }
+  for (int64_t key = 1; key <= 2 * num_keys; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  current_key = 2;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+    current_key = current_key + 2;
+  }
+  EXPECT_EQ(2 * num_keys + 2, current_key);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
   delete bpm;
-  remove("test.db");
-  remove("test.log");
+  delete disk_manager;
+  remove("b_plus_tree_insert_test.db");
+  remove("b_plus_tree_insert_test.log");
+  remove("b_plus_tree_insert_test.crc");
+  remove("b_plus_tree_insert_test.fsm");
 }
 }  // namespace bustub
@@ -57,7 +57,7 @@ TEST(BptTreeTest, UnitTest) {
   auto key_schema = ParseCreateStatement(create_stmt);
   GenericComparator<8> comparator(key_schema.get());
 
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = new DiskManager("b_plus_tree_print_test.db");
   BufferPoolManager *bpm = new BufferPoolManagerInstance(100, disk_manager);
   // create and fetch header_page
   page_id_t page_id;
@@ -112,7 +112,8 @@ TEST(BptTreeTest, UnitTest) {
   delete bpm;
   delete transaction;
   delete disk_manager;
-  remove("test.db");
-  remove("test.log");
+  remove("b_plus_tree_print_test.db");
+  remove("b_plus_tree_print_test.log");
+  remove("b_plus_tree_print_test.crc");
 }
 }  // namespace bustub
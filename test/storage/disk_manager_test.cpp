@@ -10,11 +10,27 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
 
+#include "common/bustub_instance.h"
 #include "common/exception.h"
+#include "common/util/checksum_util.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/page/header_page.h"
+#include "storage/page/page.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
@@ -22,14 +38,20 @@ class DiskManagerTest : public ::testing::Test {
  protected:
   // This function is called before every test.
   void SetUp() override {
-    remove("test.db");
-    remove("test.log");
+    remove("disk_manager_test.db");
+    remove("disk_manager_test.log");
+    remove("disk_manager_test.crc");
+    remove("disk_manager_test.ext");
+    remove("disk_manager_test.fsm");
   }
 
   // This function is called after every test.
   void TearDown() override {
-    remove("test.db");
-    remove("test.log");
+    remove("disk_manager_test.db");
+    remove("disk_manager_test.log");
+    remove("disk_manager_test.crc");
+    remove("disk_manager_test.ext");
+    remove("disk_manager_test.fsm");
   };
 };
 
@@ -37,7 +59,7 @@ class DiskManagerTest : public ::testing::Test {
 TEST_F(DiskManagerTest, ReadWritePageTest) {
   char buf[PAGE_SIZE] = {0};
   char data[PAGE_SIZE] = {0};
-  std::string db_file("test.db");
+  std::string db_file("disk_manager_test.db");
   auto dm = DiskManager(db_file);
   std::strncpy(data, "A test string.", sizeof(data));
 
@@ -55,11 +77,204 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PosixReadWritePageTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("disk_manager_test.db");
+  auto dm = DiskManager(db_file, DiskIOBackend::POSIX);
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  dm.ReadPage(0, buf);  // tolerate empty read
+
+  dm.WritePage(0, data);
+  dm.ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  std::memset(buf, 0, sizeof(buf));
+  dm.WritePage(5, data);
+  dm.ReadPage(5, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  // pages that were never written read back as zeros
+  dm.ReadPage(3, buf);
+  EXPECT_EQ(buf[0], 0);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PosixConcurrentReadWritePageTest) {
+  const int num_threads = 4;
+  const int pages_per_thread = 16;
+  std::string db_file("disk_manager_test.db");
+  auto dm = DiskManager(db_file, DiskIOBackend::POSIX);
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&dm, tid] {
+      char buf[PAGE_SIZE];
+      char data[PAGE_SIZE];
+      for (int i = 0; i < pages_per_thread; ++i) {
+        page_id_t page_id = i * num_threads + tid;
+        std::memset(data, page_id, sizeof(data));
+        dm.WritePage(page_id, data);
+        dm.ReadPage(page_id, buf);
+        EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * pages_per_thread, dm.GetNumWrites());
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PosixShutDownWhileWritingTest) {
+  const int num_threads = 4;
+  std::string db_file("disk_manager_test.db");
+  DiskManager dm(db_file, DiskIOBackend::POSIX);
+
+  // Scenario: pages are written while the disk manager shuts down. The writes that come too late fail, and none of
+  // them lands in a file opened after the shutdown, which may get one of the closed descriptors.
+  std::atomic<int> num_written{0};
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&dm, &num_written, &stop, tid] {
+      char data[PAGE_SIZE];
+      std::memset(data, tid + 1, sizeof(data));
+      for (page_id_t page_id = tid; !stop; page_id = (page_id + num_threads) % 64) {
+        dm.WritePage(page_id, data);
+        ++num_written;
+      }
+    });
+  }
+  while (num_written < 100) {
+    std::this_thread::yield();
+  }
+  dm.ShutDown();
+  int other_fd = open("disk_manager_test_other.db", O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ASSERT_GE(other_fd, 0);
+  int num_written_at_shutdown = num_written;
+  while (num_written < num_written_at_shutdown + 100) {
+    std::this_thread::yield();
+  }
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  struct stat other_stat;
+  ASSERT_EQ(0, fstat(other_fd, &other_stat));
+  EXPECT_EQ(0, other_stat.st_size);
+  close(other_fd);
+  remove("disk_manager_test_other.db");
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectReadWritePageTest) {
+  alignas(PAGE_SIZE) char aligned_buf[PAGE_SIZE] = {0};
+  char buf[PAGE_SIZE + 1] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("disk_manager_test.db");
+  auto dm = DiskManager(db_file, DiskIOBackend::POSIX_DIRECT);
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  dm.ReadPage(0, aligned_buf);  // tolerate empty read
+
+  // aligned buffers are used for direct I/O as is
+  dm.WritePage(0, data);
+  dm.ReadPage(0, aligned_buf);
+  EXPECT_EQ(std::memcmp(aligned_buf, data, sizeof(data)), 0);
+
+  // unaligned buffers go through a bounce buffer
+  dm.WritePage(5, data);
+  dm.ReadPage(5, buf + 1);
+  EXPECT_EQ(std::memcmp(buf + 1, data, sizeof(data)), 0);
+
+  // a page created outside of a buffer pool owns zeroed, aligned data of its own
+  auto page = std::make_unique<Page>();
+  ASSERT_NE(nullptr, page->GetData());
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+  EXPECT_EQ(0, page->GetLSN());
+  dm.ReadPage(0, page->GetData());
+  EXPECT_EQ(std::memcmp(page->GetData(), data, sizeof(data)), 0);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ReadPagesTest) {
+  const int num_pages = 8;
+  std::string db_file("disk_manager_test.db");
+  for (auto backend : {DiskIOBackend::FSTREAM, DiskIOBackend::POSIX, DiskIOBackend::POSIX_DIRECT}) {
+    auto dm = DiskManager(db_file, backend);
+    char data[PAGE_SIZE];
+    for (int i = 0; i < num_pages; ++i) {
+      std::memset(data, 'a' + i, sizeof(data));
+      dm.WritePage(i, data);
+    }
+
+    // a run of consecutive pages, a gap, an unaligned buffer and a page past the end of the file, out of order
+    std::vector<page_id_t> page_ids{4, 2, 3, 6, 0, num_pages + 2};
+    alignas(PAGE_SIZE) static char bufs[6][PAGE_SIZE + 1];
+    std::vector<char *> page_data{bufs[0], bufs[1], bufs[2], bufs[3], bufs[4] + 1, bufs[5]};
+    dm.ReadPages(page_ids, page_data);
+    for (size_t i = 0; i + 1 < page_ids.size(); ++i) {
+      std::memset(data, 'a' + page_ids[i], sizeof(data));
+      EXPECT_EQ(std::memcmp(page_data[i], data, PAGE_SIZE), 0);
+    }
+
+    dm.ShutDown();
+    remove("disk_manager_test.db");
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  const int num_pages = 8;
+  std::string db_file("disk_manager_test.db");
+  for (auto backend : {DiskIOBackend::FSTREAM, DiskIOBackend::POSIX, DiskIOBackend::POSIX_DIRECT}) {
+    auto dm = DiskManager(db_file, backend);
+
+    // a run of consecutive pages, a gap and an unaligned buffer, out of order
+    std::vector<page_id_t> page_ids{4, 2, 3, 6, 0, 7};
+    alignas(PAGE_SIZE) static char bufs[6][2 * PAGE_SIZE];
+    std::vector<const char *> page_data;
+    for (size_t i = 0; i < page_ids.size(); ++i) {
+      char *buf = i == 3 ? bufs[i] + 1 : bufs[i];
+      std::memset(buf, 'a' + page_ids[i], PAGE_SIZE);
+      page_data.push_back(buf);
+    }
+    dm.WritePages(page_ids, page_data);
+    dm.Sync();
+    EXPECT_EQ(page_ids.size(), dm.GetNumWrites());
+
+    char data[PAGE_SIZE];
+    char buf[PAGE_SIZE];
+    for (page_id_t page_id : page_ids) {
+      dm.ReadPage(page_id, buf);
+      std::memset(data, 'a' + page_id, sizeof(data));
+      EXPECT_EQ(std::memcmp(buf, data, PAGE_SIZE), 0);
+    }
+    EXPECT_EQ(0, dm.GetNumChecksumFailures());
+    dm.ReadPage(num_pages - 3, buf);
+    std::memset(data, 0, sizeof(data));
+    EXPECT_EQ(std::memcmp(buf, data, PAGE_SIZE), 0);
+
+    dm.ShutDown();
+    remove("disk_manager_test.db");
+  }
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
   char data[16] = {0};
-  std::string db_file("test.db");
+  std::string db_file("disk_manager_test.db");
   auto dm = DiskManager(db_file);
   std::strncpy(data, "A test string.", sizeof(data));
 
@@ -72,6 +287,301 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, HeaderPageSizeTest) {
+  const size_t offset_page_size = 4092;
+  char buf[PAGE_SIZE] = {0};
+  int page_size;
+
+  // Scenario: a new database records the page size of the build in its header page.
+  delete new BustubInstance("disk_manager_test.db", DiskIOBackend::POSIX, 16);
+  {
+    DiskManager dm("disk_manager_test.db", DiskIOBackend::POSIX);
+    dm.ReadPage(HEADER_PAGE_ID, buf);
+    std::memcpy(&page_size, buf + offset_page_size, sizeof(page_size));
+    EXPECT_EQ(PAGE_SIZE, page_size);
+
+    // Scenario: a database file created with another page size is refused.
+    page_size = PAGE_SIZE * 2;
+    std::memcpy(buf + offset_page_size, &page_size, sizeof(page_size));
+    dm.WritePage(HEADER_PAGE_ID, buf);
+    dm.ShutDown();
+  }
+  EXPECT_THROW(BustubInstance("disk_manager_test.db", DiskIOBackend::POSIX, 16), Exception);
+
+  // Scenario: a header page without a recorded page size is taken to use the current one.
+  {
+    DiskManager dm("disk_manager_test.db", DiskIOBackend::POSIX);
+    page_size = 0;
+    std::memcpy(buf + offset_page_size, &page_size, sizeof(page_size));
+    dm.WritePage(HEADER_PAGE_ID, buf);
+    dm.ShutDown();
+  }
+  delete new BustubInstance("disk_manager_test.db", DiskIOBackend::POSIX, 16);
+  DiskManager dm("disk_manager_test.db", DiskIOBackend::POSIX);
+  dm.ReadPage(HEADER_PAGE_ID, buf);
+  std::memcpy(&page_size, buf + offset_page_size, sizeof(page_size));
+  EXPECT_EQ(PAGE_SIZE, page_size);
+  dm.ShutDown();
+
+  // Scenario: once the records reach the page size, further records are refused instead of overwriting it.
+  HeaderPage header_page;
+  header_page.Init();
+  int num_records = 0;
+  while (header_page.InsertRecord("table_" + std::to_string(num_records), 1)) {
+    ++num_records;
+  }
+  EXPECT_EQ((offset_page_size - 4) / 36, num_records);
+  EXPECT_EQ(false, header_page.InsertRecord("table_0", 1));
+  EXPECT_EQ(PAGE_SIZE, header_page.GetPageSize());
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumTest) {
+  EXPECT_EQ(0xE3069283, ChecksumUtil::Crc32c("123456789", 9));
+  ScopedSetting checksums(&enable_page_checksums, true);
+
+  for (auto backend : {DiskIOBackend::FSTREAM, DiskIOBackend::POSIX}) {
+    char buf[PAGE_SIZE] = {0};
+    char data[PAGE_SIZE] = {0};
+    {
+      DiskManager dm("disk_manager_test.db", backend);
+      for (page_id_t page_id = 0; page_id < 4; ++page_id) {
+        std::memset(data, 'a' + page_id, sizeof(data));
+        dm.WritePage(page_id, data);
+      }
+      dm.ShutDown();
+    }
+
+    // Scenario: flip a byte of page 2 behind the disk manager's back, and tear the write of page 3.
+    {
+      std::fstream file("disk_manager_test.db", std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(2 * PAGE_SIZE + 100);
+      file.put('z');
+    }
+    ASSERT_EQ(0, truncate("disk_manager_test.db", 3 * PAGE_SIZE + PAGE_SIZE / 2));
+
+    DiskManager dm("disk_manager_test.db", backend);
+    dm.ReadPage(1, buf);
+    std::memset(data, 'b', sizeof(data));
+    EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+    EXPECT_THROW(dm.ReadPage(2, buf), Exception);
+    EXPECT_THROW(dm.ReadPage(3, buf), Exception);
+    EXPECT_EQ(2, dm.GetNumChecksumFailures());
+
+    // Scenario: a batch with a corrupted page still reads the intact ones before reporting it.
+    char bufs[3][PAGE_SIZE];
+    EXPECT_THROW(dm.ReadPages({0, 1, 2}, {bufs[0], bufs[1], bufs[2]}), Exception);
+    EXPECT_EQ(3, dm.GetNumChecksumFailures());
+    std::memset(data, 'a', sizeof(data));
+    EXPECT_EQ(0, std::memcmp(bufs[0], data, sizeof(data)));
+    std::memset(data, 'b', sizeof(data));
+    EXPECT_EQ(0, std::memcmp(bufs[1], data, sizeof(data)));
+
+    // Scenario: rewriting the page repairs it, and pages that were never written are not checked.
+    dm.WritePage(2, data);
+    dm.ReadPage(2, buf);
+    dm.ReadPage(10, buf);
+    EXPECT_EQ(3, dm.GetNumChecksumFailures());
+
+    // Scenario: a write that never reached the file leaves the previous image, which is still accepted.
+    std::memset(data, 'c', sizeof(data));
+    dm.WritePage(1, data);
+    {
+      std::fstream file("disk_manager_test.db", std::ios::binary | std::ios::in | std::ios::out);
+      std::memset(data, 'b', sizeof(data));
+      file.seekp(PAGE_SIZE);
+      file.write(data, sizeof(data));
+    }
+    dm.ReadPage(1, buf);
+    EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+    EXPECT_EQ(3, dm.GetNumChecksumFailures());
+
+    // Scenario: a batch stores the checksum of every page in it, whether or not the ids are consecutive.
+    char batch[3][PAGE_SIZE];
+    for (int i = 0; i < 3; ++i) {
+      std::memset(batch[i], 'd' + i, PAGE_SIZE);
+    }
+    EXPECT_TRUE(dm.WritePages({6, 4, 5}, {batch[0], batch[1], batch[2]}));
+    {
+      std::fstream file("disk_manager_test.db", std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(6 * PAGE_SIZE + 100);
+      file.put('z');
+    }
+    dm.ReadPage(4, buf);
+    EXPECT_EQ(0, std::memcmp(buf, batch[1], sizeof(buf)));
+    EXPECT_THROW(dm.ReadPage(6, buf), Exception);
+    EXPECT_EQ(4, dm.GetNumChecksumFailures());
+
+    dm.ShutDown();
+    remove("disk_manager_test.db");
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumOverheadBenchmark) {
+  const int num_pages = 256;
+  const int rounds = 20;
+  char data[PAGE_SIZE] = {0};
+  {
+    DiskManager dm("disk_manager_test.db", DiskIOBackend::POSIX);
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      std::memset(data, page_id, sizeof(data));
+      dm.WritePage(page_id, data);
+    }
+    dm.ShutDown();
+  }
+
+  // Reads come from the OS page cache, which is the worst case for the relative overhead of the checksum.
+  auto time_reads = [&](bool checksums) {
+    ScopedSetting checksum_setting(&enable_page_checksums, checksums);
+    DiskManager dm("disk_manager_test.db", DiskIOBackend::POSIX);
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+      for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+        dm.ReadPage(page_id, data);
+      }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(0, dm.GetNumChecksumFailures());
+    dm.ShutDown();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / (num_pages * rounds);
+  };
+  time_reads(false);
+  auto unchecked_ns = time_reads(false);
+  auto checked_ns = time_reads(true);
+  // Timings depend on the machine, so they are only reported.
+  std::cout << "ReadPage: " << unchecked_ns << " ns without checksums, " << checked_ns << " ns with checksums ("
+            << (ChecksumUtil::HasHardwareCrc32c() ? "SSE4.2" : "software") << " CRC32C)" << std::endl;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressionTest) {
+  const int num_pages = 64;
+  std::mt19937 rng(15445);
+  std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE, 0));
+  for (int i = 0; i < num_pages; ++i) {
+    if (i % 8 == 0) {
+      // incompressible
+      for (auto &byte : pages[i]) {
+        byte = static_cast<char>(rng());
+      }
+    } else {
+      // a mostly empty table page: a header and a few tuples at the end
+      std::memset(pages[i].data(), i, 24);
+      std::memset(pages[i].data() + PAGE_SIZE - 100 * (i % 5), 'x', 100 * (i % 5));
+    }
+  }
+  auto file_size = [](const char *file_name) {
+    std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+    return static_cast<int64_t>(file.tellg());
+  };
+
+  ScopedSetting compression(&enable_page_compression, true);
+  char buf[PAGE_SIZE];
+  {
+    DiskManager dm("disk_manager_test.db", DiskIOBackend::POSIX_DIRECT);
+    for (int i = 0; i < num_pages; ++i) {
+      dm.WritePage(i, pages[i].data());
+    }
+    for (int i = 0; i < num_pages; ++i) {
+      dm.ReadPage(i, buf);
+      EXPECT_EQ(0, std::memcmp(buf, pages[i].data(), PAGE_SIZE)) << "page " << i;
+    }
+    // Scenario: pages that were never written read as zeros.
+    dm.ReadPage(num_pages + 10, buf);
+    EXPECT_EQ(0, std::memcmp(buf, std::vector<char>(PAGE_SIZE, 0).data(), PAGE_SIZE));
+
+    // Scenario: mostly empty pages take a fraction of the space, incompressible pages take no more than before.
+    EXPECT_LT(file_size("disk_manager_test.db"), num_pages * PAGE_SIZE / 4);
+
+    // Scenario: a page that no longer fits its extent moves, and the pages around it are not touched.
+    for (auto &byte : pages[9]) {
+      byte = static_cast<char>(rng());
+    }
+    dm.WritePage(9, pages[9].data());
+    std::vector<char *> bufs;
+    std::vector<page_id_t> page_ids;
+    std::vector<std::vector<char>> batch(3, std::vector<char>(PAGE_SIZE));
+    for (int i = 0; i < 3; ++i) {
+      page_ids.push_back(8 + i);
+      bufs.push_back(batch[i].data());
+    }
+    dm.ReadPages(page_ids, bufs);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(0, std::memcmp(batch[i].data(), pages[8 + i].data(), PAGE_SIZE)) << "page " << 8 + i;
+    }
+
+    // Scenario: the extent page 9 moved out of goes to the next page that fits in it, instead of growing the file.
+    int64_t size = file_size("disk_manager_test.db");
+    dm.WritePage(num_pages, pages[1].data());
+    EXPECT_EQ(size, file_size("disk_manager_test.db"));
+    dm.ReadPage(num_pages, buf);
+    EXPECT_EQ(0, std::memcmp(buf, pages[1].data(), PAGE_SIZE));
+    dm.ShutDown();
+  }
+
+  // Scenario: the extent map survives reopening the database.
+  {
+    DiskManager dm("disk_manager_test.db", DiskIOBackend::POSIX);
+    for (int i = 0; i < num_pages; ++i) {
+      dm.ReadPage(i, buf);
+      EXPECT_EQ(0, std::memcmp(buf, pages[i].data(), PAGE_SIZE)) << "page " << i;
+    }
+    EXPECT_EQ(0, dm.GetNumChecksumFailures());
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreeSpaceMapTest) {
+  char data[PAGE_SIZE] = {0};
+  char buf[PAGE_SIZE] = {0};
+  {
+    DiskManager dm("disk_manager_test.db");
+    for (page_id_t page_id = 0; page_id < 12; ++page_id) {
+      std::memset(data, 'a' + page_id, sizeof(data));
+      dm.WritePage(page_id, data);
+    }
+    EXPECT_EQ(12, dm.GetNumPages());
+    EXPECT_EQ(INVALID_PAGE_ID, dm.ReuseFreePage(1, 0));
+
+    // Scenario: the free-space map is only created by the first deallocated page.
+    struct stat stat_buf;
+    EXPECT_NE(0, stat("disk_manager_test.fsm", &stat_buf));
+
+    // Scenario: free pages are only handed out to the instance that owns their id.
+    for (page_id_t page_id : {3, 4, 9, 10, 11}) {
+      dm.DeallocatePage(page_id);
+    }
+    EXPECT_EQ(0, stat("disk_manager_test.fsm", &stat_buf));
+    EXPECT_EQ(4, dm.ReuseFreePage(2, 0));
+    EXPECT_EQ(10, dm.ReuseFreePage(2, 0));
+    EXPECT_EQ(INVALID_PAGE_ID, dm.ReuseFreePage(2, 0));
+    dm.DeallocatePage(10);
+    dm.ShutDown();
+  }
+
+  // Scenario: the free-space map survives reopening, and compaction cuts only the free tail of the file.
+  {
+    DiskManager dm("disk_manager_test.db");
+    EXPECT_EQ(3, dm.TruncateFreePages());
+    EXPECT_EQ(9, dm.GetNumPages());
+    EXPECT_EQ(0, dm.TruncateFreePages());
+    dm.ReadPage(8, buf);
+    std::memset(data, 'a' + 8, sizeof(data));
+    EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+    dm.ShutDown();
+  }
+  {
+    DiskManager dm("disk_manager_test.db");
+    EXPECT_EQ(9, dm.GetNumPages());
+    EXPECT_EQ(3, dm.ReuseFreePage(1, 0));
+    EXPECT_EQ(INVALID_PAGE_ID, dm.ReuseFreePage(1, 0));
+    dm.ShutDown();
+  }
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
@@ -0,0 +1,207 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// generic_key_test.cpp
+//
+// Identification: test/storage/generic_key_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/generic_key.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/config.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// The comparison a key made of these values should have, column by column through Values.
+static auto CompareValues(const std::vector<Value> &lhs, const std::vector<Value> &rhs) -> int {
+  for (size_t i = 0; i < lhs.size(); i++) {
+    if (lhs[i].CompareLessThan(rhs[i]) == CmpBool::CmpTrue) {
+      return -1;
+    }
+    if (lhs[i].CompareGreaterThan(rhs[i]) == CmpBool::CmpTrue) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// NOLINTNEXTLINE
+TEST(GenericKeyTest, IntegerComparatorTest) {
+  auto key_schema = ParseCreateStatement("a tinyint,b smallint,c integer,d bigint");
+  GenericComparator<16> comparator(key_schema.get());
+
+  // Scenario: integer keys are compared in place, and order like their Values do, NULL included.
+  std::mt19937 rng(15445);
+  auto random_values = [&] {
+    // A small range, so that the later columns get to decide often.
+    auto pick = [&](int64_t null_value) -> int64_t {
+      int64_t value = static_cast<int64_t>(rng() % 7) - 3;
+      return value == 3 ? null_value : value;
+    };
+    return std::vector<Value>{ValueFactory::GetTinyIntValue(static_cast<int8_t>(pick(BUSTUB_INT8_NULL))),
+                              ValueFactory::GetSmallIntValue(static_cast<int16_t>(pick(BUSTUB_INT16_NULL))),
+                              ValueFactory::GetIntegerValue(static_cast<int32_t>(pick(BUSTUB_INT32_NULL))),
+                              ValueFactory::GetBigIntValue(pick(BUSTUB_INT64_NULL) * 1000000000000)};
+  };
+
+  for (int i = 0; i < 10000; i++) {
+    auto lhs_values = random_values();
+    auto rhs_values = random_values();
+    GenericKey<16> lhs;
+    GenericKey<16> rhs;
+    lhs.SetFromKey(Tuple(lhs_values, key_schema.get()));
+    rhs.SetFromKey(Tuple(rhs_values, key_schema.get()));
+    EXPECT_EQ(CompareValues(lhs_values, rhs_values), comparator(lhs, rhs));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(GenericKeyTest, MixedComparatorTest) {
+  auto key_schema = ParseCreateStatement("a integer,b varchar(8)");
+  GenericComparator<32> comparator(key_schema.get());
+
+  // Scenario: keys with a column that isn't an integer are still compared through Values.
+  std::vector<std::vector<Value>> values{
+      {ValueFactory::GetIntegerValue(-1), ValueFactory::GetVarcharValue("b")},
+      {ValueFactory::GetIntegerValue(1), ValueFactory::GetVarcharValue("a")},
+      {ValueFactory::GetIntegerValue(1), ValueFactory::GetVarcharValue("ab")},
+      {ValueFactory::GetIntegerValue(2), ValueFactory::GetVarcharValue("")},
+  };
+  for (const auto &lhs_values : values) {
+    for (const auto &rhs_values : values) {
+      GenericKey<32> lhs;
+      GenericKey<32> rhs;
+      lhs.SetFromKey(Tuple(lhs_values, key_schema.get()));
+      rhs.SetFromKey(Tuple(rhs_values, key_schema.get()));
+      EXPECT_EQ(CompareValues(lhs_values, rhs_values), comparator(lhs, rhs));
+    }
+  }
+}
+
+// The comparison a normalized key made of these values should have: like Values, except that NULL comes first.
+static auto CompareValuesNullsFirst(const std::vector<Value> &lhs, const std::vector<Value> &rhs) -> int {
+  for (size_t i = 0; i < lhs.size(); i++) {
+    if (lhs[i].IsNull() || rhs[i].IsNull()) {
+      if (lhs[i].IsNull() != rhs[i].IsNull()) {
+        return lhs[i].IsNull() ? -1 : 1;
+      }
+      continue;
+    }
+    int result = CompareValues({lhs[i]}, {rhs[i]});
+    if (result != 0) {
+      return result;
+    }
+  }
+  return 0;
+}
+
+// NOLINTNEXTLINE
+TEST(GenericKeyTest, NormalizedKeyTest) {
+  auto key_schema = ParseCreateStatement("a smallint,b varchar(4),c double,d bigint,e boolean");
+  ASSERT_TRUE(GenericKey<32>::CanNormalize(key_schema.get()));
+  EXPECT_FALSE(GenericKey<16>::CanNormalize(key_schema.get()));
+  GenericComparator<32> comparator(key_schema.get(), true);
+  ASSERT_TRUE(comparator.IsNormalized());
+
+  // Scenario: memcmp orders normalized keys like their Values, with NULL first, for every type of column.
+  std::mt19937 rng(15445);
+  std::vector<Value> smallints{ValueFactory::GetSmallIntValue(BUSTUB_INT16_NULL), ValueFactory::GetSmallIntValue(-300),
+                               ValueFactory::GetSmallIntValue(-1), ValueFactory::GetSmallIntValue(0),
+                               ValueFactory::GetSmallIntValue(1), ValueFactory::GetSmallIntValue(300)};
+  std::vector<Value> varchars{ValueFactory::GetVarcharValue(""), ValueFactory::GetVarcharValue("a"),
+                              ValueFactory::GetVarcharValue(std::string("a\0", 2)), ValueFactory::GetVarcharValue("ab"),
+                              ValueFactory::GetVarcharValue("b"), ValueFactory::GetVarcharValue("\xff")};
+  std::vector<Value> decimals{ValueFactory::GetDecimalValue(BUSTUB_DECIMAL_NULL), ValueFactory::GetDecimalValue(-1e100),
+                              ValueFactory::GetDecimalValue(-1.5),  ValueFactory::GetDecimalValue(-0.0),
+                              ValueFactory::GetDecimalValue(0.0),   ValueFactory::GetDecimalValue(0.25),
+                              ValueFactory::GetDecimalValue(1e100)};
+  std::vector<Value> bigints{ValueFactory::GetBigIntValue(BUSTUB_INT64_NULL), ValueFactory::GetBigIntValue(-(1LL << 40)),
+                             ValueFactory::GetBigIntValue(-1), ValueFactory::GetBigIntValue(255),
+                             ValueFactory::GetBigIntValue(256), ValueFactory::GetBigIntValue(1LL << 40)};
+  std::vector<Value> booleans{ValueFactory::GetBooleanValue(CmpBool::CmpNull), ValueFactory::GetBooleanValue(false),
+                              ValueFactory::GetBooleanValue(true)};
+  auto random_values = [&] {
+    return std::vector<Value>{smallints[rng() % smallints.size()], varchars[rng() % varchars.size()],
+                              decimals[rng() % decimals.size()], bigints[rng() % bigints.size()],
+                              booleans[rng() % booleans.size()]};
+  };
+
+  for (int i = 0; i < 10000; i++) {
+    auto lhs_values = random_values();
+    auto rhs_values = random_values();
+    GenericKey<32> lhs;
+    GenericKey<32> rhs;
+    lhs.SetFromKey(Tuple(lhs_values, key_schema.get()), comparator);
+    rhs.SetFromKey(Tuple(rhs_values, key_schema.get()), comparator);
+    EXPECT_EQ(CompareValuesNullsFirst(lhs_values, rhs_values), comparator(lhs, rhs));
+  }
+
+  // Scenario: a varchar longer than its column doesn't fit into its normalized form.
+  GenericKey<32> key;
+  std::vector<Value> long_values{smallints[1], ValueFactory::GetVarcharValue("abcde"), decimals[1], bigints[1],
+                                 booleans[1]};
+  EXPECT_THROW(key.SetFromKey(Tuple(long_values, key_schema.get()), comparator), Exception);
+}
+
+// NOLINTNEXTLINE
+TEST(GenericKeyTest, NormalizedIndexTest) {
+  ScopedSetting normalized_keys(&enable_normalized_keys, true);
+  auto *disk_manager = new DiskManager("generic_key_test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  // Scenario: an index created with normalized keys orders them with memcmp, negative keys before positive ones.
+  auto schema = ParseCreateStatement("a integer,b integer");
+  auto metadata = std::make_unique<IndexMetadata>("foo_pk", "foo", schema.get(), std::vector<uint32_t>{1});
+  BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(std::move(metadata), bpm);
+  auto *key_schema = index.GetKeySchema();
+  std::vector<int32_t> keys{3, -1, 0, 256, -256, 1, -300000};
+  for (auto key : keys) {
+    Tuple tuple({ValueFactory::GetIntegerValue(0), ValueFactory::GetIntegerValue(key)}, schema.get());
+    index.InsertEntry(tuple.KeyFromTuple(*schema, *key_schema, index.GetKeyAttrs()), RID(0, key), nullptr);
+  }
+
+  std::sort(keys.begin(), keys.end());
+  size_t i = 0;
+  GenericKey<8> prev_key;
+  for (auto iterator = index.GetBeginIterator(); iterator != index.GetEndIterator(); ++iterator) {
+    ASSERT_LT(i, keys.size());
+    EXPECT_EQ(keys[i++], (*iterator).second.GetSlotNum());
+    if (i > 1) {
+      EXPECT_LT(memcmp(prev_key.data_, (*iterator).first.data_, sizeof(prev_key.data_)), 0);
+    }
+    prev_key = (*iterator).first;
+  }
+  EXPECT_EQ(keys.size(), i);
+
+  std::vector<RID> rids;
+  Tuple tuple({ValueFactory::GetIntegerValue(-256)}, key_schema);
+  index.ScanKey(tuple, &rids, nullptr);
+  ASSERT_EQ(1, rids.size());
+  EXPECT_EQ(-256, rids[0].GetSlotNum());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("generic_key_test.db");
+  remove("generic_key_test.crc");
+}
+
+}  // namespace bustub
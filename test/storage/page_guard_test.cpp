@@ -0,0 +1,153 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/storage/page_guard_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/page_guard.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, SampleTest) {
+  const std::string db_name = "page_guard_test.db";
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  Page *page = nullptr;
+  {
+    BasicPageGuard guard = bpm->NewPageGuarded(&page_id);
+    ASSERT_TRUE(guard.IsValid());
+    page = guard.GetPage();
+    EXPECT_EQ(page_id, guard.PageId());
+    EXPECT_EQ(1, page->GetPinCount());
+    std::strcpy(guard.GetDataMut(), "Hello");  // NOLINT
+
+    // Scenario: moving a guard hands the pin over without taking another one.
+    BasicPageGuard moved = std::move(guard);
+    EXPECT_FALSE(guard.IsValid());  // NOLINT
+    EXPECT_TRUE(moved.IsValid());
+    EXPECT_EQ(1, page->GetPinCount());
+  }
+  // Scenario: the pin is released when the guard goes out of scope, and the page was unpinned dirty.
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_TRUE(page->IsDirty());
+
+  {
+    // Scenario: a read guard holds the read latch, so other readers still get in.
+    ReadPageGuard guard = bpm->FetchPageRead(page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_EQ(0, std::strcmp(guard.GetData(), "Hello"));
+    ReadPageGuard other = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(2, page->GetPinCount());
+    other.Drop();
+    EXPECT_EQ(1, page->GetPinCount());
+
+    // Scenario: assigning to a guard releases the page it held first.
+    guard = ReadPageGuard();
+    EXPECT_EQ(0, page->GetPinCount());
+    EXPECT_FALSE(guard.IsValid());
+  }
+
+  bpm->FlushPage(page_id);
+  EXPECT_FALSE(page->IsDirty());
+  {
+    // Scenario: a write guard only unpins dirty once the page was accessed mutably.
+    WritePageGuard guard = bpm->FetchPageWrite(page_id);
+    EXPECT_EQ(0, std::strcmp(guard.GetData(), "Hello"));
+    guard.Drop();
+    EXPECT_FALSE(page->IsDirty());
+    EXPECT_FALSE(guard.IsValid());
+
+    guard = bpm->FetchPageWrite(page_id);
+    std::strcpy(guard.AsMut<char>(), "World");  // NOLINT
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_TRUE(page->IsDirty());
+
+  {
+    // Scenario: upgrading a guard latches the page and keeps its pin; the latch is released with the guard.
+    WritePageGuard write_guard = bpm->FetchPageBasic(page_id).UpgradeWrite();
+    ASSERT_TRUE(write_guard.IsValid());
+    EXPECT_EQ(1, page->GetPinCount());
+    write_guard.Drop();
+    ReadPageGuard read_guard = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(0, std::strcmp(read_guard.GetData(), "World"));
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  // Scenario: a page that can't be fetched yields an empty guard, which releases nothing.
+  std::vector<BasicPageGuard> guards;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t temp_page_id;
+    guards.push_back(bpm->NewPageGuarded(&temp_page_id));
+    ASSERT_TRUE(guards.back().IsValid());
+  }
+  EXPECT_FALSE(bpm->FetchPageRead(page_id).IsValid());
+  EXPECT_FALSE(bpm->NewPageGuarded(&page_id).IsValid());
+  guards.clear();
+
+  disk_manager->ShutDown();
+  remove("page_guard_test.db");
+  remove("page_guard_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, ParallelTest) {
+  const std::string db_name = "page_guard_test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(4, 5, disk_manager);
+
+  // Scenario: guards of a parallel buffer pool unpin in the instance the page belongs to.
+  std::vector<Page *> pages;
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 8; ++i) {
+    page_id_t page_id;
+    BasicPageGuard guard = bpm->NewPageGuarded(&page_id);
+    ASSERT_TRUE(guard.IsValid());
+    snprintf(guard.GetDataMut(), PAGE_SIZE, "page %d", page_id);
+    pages.push_back(guard.GetPage());
+    page_ids.push_back(page_id);
+  }
+  for (size_t i = 0; i < pages.size(); ++i) {
+    EXPECT_EQ(0, pages[i]->GetPinCount());
+    ReadPageGuard guard = bpm->FetchPageRead(page_ids[i]);
+    EXPECT_EQ(pages[i], guard.GetPage());
+    EXPECT_EQ("page " + std::to_string(page_ids[i]), std::string(guard.GetData()));
+    EXPECT_EQ(1, pages[i]->GetPinCount());
+  }
+  for (Page *page : pages) {
+    EXPECT_EQ(0, page->GetPinCount());
+  }
+
+  disk_manager->ShutDown();
+  remove("page_guard_test.db");
+  remove("page_guard_test.crc");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -21,6 +21,8 @@
 #include "logging/common.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
 
 namespace bustub {
 // NOLINTNEXTLINE
@@ -38,7 +40,7 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
 
   // create transaction
   auto *transaction = new Transaction(0);
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = new DiskManager("tuple_test.db");
   auto *buffer_pool_manager = new BufferPoolManagerInstance(50, disk_manager);
   auto *lock_manager = new LockManager();
   auto *log_manager = new LogManager(disk_manager);
@@ -64,11 +66,81 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
     assert(table->MarkDelete(rid, transaction) == 1);
   }
   disk_manager->ShutDown();
-  remove("test.db");  // remove db file
-  remove("test.log");
+  remove("tuple_test.db");  // remove db file
+  remove("tuple_test.log");
+  remove("tuple_test.crc");
   delete table;
   delete buffer_pool_manager;
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(TupleTest, TableHeapScanTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 256};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+
+  ScopedSetting readahead(&enable_readahead, true);
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("tuple_test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(64, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+
+  // Enough tuples to span many more pages than the buffer pool holds.
+  const int num_tuples = 2000;
+  std::vector<RID> rid_v;
+  for (int i = 0; i < num_tuples; ++i) {
+    Tuple tuple{{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(200, 'x'))}, &schema};
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+    rid_v.push_back(rid);
+  }
+  ASSERT_GT(rid_v.back().GetPageId() - rid_v.front().GetPageId(), 64);
+
+  // Scenario: a scan over the table heap that built the chain reads every tuple in insertion order.
+  int i = 0;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr, ++i) {
+    ASSERT_LT(i, num_tuples);
+    EXPECT_EQ(rid_v[i], itr->GetRid());
+    EXPECT_EQ(i, itr->GetValue(&schema, 0).GetAs<int32_t>());
+  }
+  EXPECT_EQ(num_tuples, i);
+
+  // Scenario: a reopened table heap learns the chain on its first scan and reads ahead on the second one.
+  auto *reopened = new TableHeap(buffer_pool_manager, lock_manager, log_manager, table->GetFirstPageId());
+  for (int scan = 0; scan < 2; ++scan) {
+    i = 0;
+    for (auto itr = reopened->Begin(transaction); itr != reopened->End(); ++itr, ++i) {
+      ASSERT_LT(i, num_tuples);
+      EXPECT_EQ(rid_v[i], itr->GetRid());
+    }
+    EXPECT_EQ(num_tuples, i);
+  }
+
+  // Scenario: a bulk scan through a buffer access strategy reads the same tuples.
+  BufferAccessStrategy strategy;
+  i = 0;
+  for (auto itr = table->Begin(transaction, &strategy); itr != table->End(); ++itr, ++i) {
+    ASSERT_LT(i, num_tuples);
+    EXPECT_EQ(rid_v[i], itr->GetRid());
+    EXPECT_EQ(i, itr->GetValue(&schema, 0).GetAs<int32_t>());
+  }
+  EXPECT_EQ(num_tuples, i);
+
+  disk_manager->ShutDown();
+  remove("tuple_test.db");
+  remove("tuple_test.log");
+  remove("tuple_test.crc");
+  delete reopened;
+  delete table;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
 }  // namespace bustub
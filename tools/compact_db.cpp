@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compact_db.cpp
+//
+// Identification: tools/compact_db.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "common/config.h"
+#include "common/exception.h"
+#include "storage/disk/disk_manager.h"
+
+/**
+ * Shrinks a database file that is not in use by cutting the free pages off its end.
+ *
+ * Usage: compact_db [--compressed] <db file>
+ */
+auto main(int argc, char **argv) -> int {
+  bool compressed = argc == 3 && std::strcmp(argv[1], "--compressed") == 0;
+  if (argc != 2 && !compressed) {
+    std::cerr << "usage: " << argv[0] << " [--compressed] <db file>" << std::endl;
+    return 1;
+  }
+  std::string db_file = argv[argc - 1];
+  if (!std::ifstream(db_file).good()) {
+    std::cerr << db_file << ": no such database file" << std::endl;
+    return 1;
+  }
+  // Opening a database with the wrong format would read garbage, so refuse unless the extent file agrees.
+  std::string base_name = db_file.substr(0, db_file.find_last_of('.'));
+  bool has_extents = std::ifstream(base_name + ".ext").good();
+  if (compressed != has_extents) {
+    std::cerr << db_file << ": database file is " << (has_extents ? "" : "not ") << "compressed, run "
+              << (has_extents ? "with" : "without") << " --compressed" << std::endl;
+    return 1;
+  }
+  bustub::enable_page_compression = compressed;
+  // checksums of the cut pages must go too, or they would be applied to the pages that get the ids next
+  bustub::enable_page_checksums = std::ifstream(base_name + ".crc").good();
+
+  try {
+    bustub::DiskManager disk_manager(db_file, bustub::DiskIOBackend::POSIX);
+    bustub::page_id_t num_pages = disk_manager.GetNumPages();
+    bustub::page_id_t num_cut = disk_manager.TruncateFreePages();
+    std::cout << db_file << ": " << num_pages << " pages, cut " << num_cut << " free pages off the end"
+              << std::endl;
+    disk_manager.ShutDown();
+  } catch (const bustub::Exception &e) {
+    std::cerr << db_file << ": " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}